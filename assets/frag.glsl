@@ -1,6 +1,5 @@
 #version 330 core
 
-#define NR_POINT_LIGHTS 10
 #define RENDER_FULLBRIGHT 0
 
 in vec3 FragPos;
@@ -28,15 +27,18 @@ struct DirLight
     vec3 specular;
 };
 
+// NOTE: Attenuation terms and the radius sit right after a vec3 each so the struct packs into 4 vec4s,
+//       which is also how it is stored in the texture buffer fallback below
 struct PointLight
 {
     vec3 position;
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
     float constant;
+    vec3 ambient;
     float linear;
+    vec3 diffuse;
     float quadratic;
+    vec3 specular;
+    float radius;       // distance past which the light adds nothing visible
 };
 
 struct SpotLight
@@ -53,16 +55,49 @@ struct SpotLight
     float outerCutOff;
 };
 
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
+layout (std140) uniform Lights
+{
+    DirLight dirLight;
+    uint pointLightCount;
+};
+
+// Point lights, any number of them (see LightManager)
+#ifdef POINT_LIGHT_STORAGE_BUFFER
+layout (std430) readonly buffer PointLights
+{
+    PointLight pointLights[];
+};
+#else
+uniform samplerBuffer pointLightData;   // 4 RGBA32F texels per light
+#endif
+
+// Froxel grid the point lights are binned into on the CPU (see LightClusters)
+layout (std140) uniform Clusters
+{
+    uvec4 gridSize;     // tiles in x, tiles in y, depth slices
+    vec4 tileSize;      // pixels per tile in x and y
+    vec4 sliceParams;   // depth slice = log(depth) * x - y
+};
+
+uniform usamplerBuffer lightGrid;       // per froxel: offset into lightIndices, light count
+uniform usamplerBuffer lightIndices;    // indices into the point lights
+
 uniform Material material;
-uniform DirLight dirLight;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
 uniform SpotLight spotLight;
 
-uniform vec3 viewPos;
 uniform sampler2D textureSrc;
 
 out vec4 FragColor;
 
+uint GetCluster();
+PointLight GetPointLight(uint index);
 vec3 GetDiffuseTexel();
 vec3 GetSpecularTexel();
 vec3 CalcDirLight(DirLight dirLight, vec3 normal, vec3 viewDir);
@@ -86,10 +121,15 @@ void main()
     //vec3 result = CalcDirLight(dirLight, normal, viewDir);
     vec3 result = GetDiffuseTexel() * 0.1;
     
-    // Point lights
+    // Point lights affecting this fragment's froxel
     // FIXME: Model goes completely dark after adding to result. Test this function.
-    for (int i = 0; i < NR_POINT_LIGHTS; i++)
-        result += CalcPointLight(pointLights[i], normal, FragPos, viewDir);
+    uvec2 range = texelFetch(lightGrid, int(GetCluster())).xy;
+    for (uint i = 0u; i < range.y; i++)
+    {
+        uint lightIndex = texelFetch(lightIndices, int(range.x + i)).x;
+        if (lightIndex < pointLightCount)
+            result += CalcPointLight(GetPointLight(lightIndex), normal, FragPos, viewDir);
+    }
     
     //// Spot light
     //result += CalcSpotLight(spotLight, normal, FragPos, viewDir);
@@ -98,6 +138,32 @@ void main()
 #endif
 }
 
+// Index of the froxel this fragment falls into
+uint GetCluster()
+{
+    float depth = -(view * vec4(FragPos, 1.0)).z;
+    uint slice = uint(max(log(depth) * sliceParams.x - sliceParams.y, 0.0));
+    uvec2 tile = uvec2(gl_FragCoord.xy / tileSize.xy);
+    tile = min(tile, gridSize.xy - 1u);
+    slice = min(slice, gridSize.z - 1u);
+    return (slice * gridSize.y + tile.y) * gridSize.x + tile.x;
+}
+
+// Fetch a point light from the light buffer
+PointLight GetPointLight(uint index)
+{
+#ifdef POINT_LIGHT_STORAGE_BUFFER
+    return pointLights[index];
+#else
+    int texel = int(index) * 4;
+    vec4 data0 = texelFetch(pointLightData, texel);
+    vec4 data1 = texelFetch(pointLightData, texel + 1);
+    vec4 data2 = texelFetch(pointLightData, texel + 2);
+    vec4 data3 = texelFetch(pointLightData, texel + 3);
+    return PointLight(data0.xyz, data0.w, data1.xyz, data1.w, data2.xyz, data2.w, data3.xyz, data3.w);
+#endif
+}
+
 // Sample diffuse texture
 vec3 GetDiffuseTexel()
 {
@@ -129,13 +195,17 @@ vec3 CalcDirLight(DirLight dirLight, vec3 normal, vec3 viewDir)
 // Point lighting
 vec3 CalcPointLight(PointLight pointLight, vec3 normal, vec3 fragPos, vec3 viewDir)
 {
+    // Froxels are coarse, skip the shading where the light can't reach
+    float distance = length(pointLight.position - fragPos);
+    if (distance > pointLight.radius)
+        return vec3(0.0);
+
     vec3 lightDir = normalize(pointLight.position - fragPos);
     vec3 reflectDir = reflect(-lightDir, normal);
 
     float diff = max(dot(normal, lightDir), 0.0);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
     
-    float distance = length(pointLight.position - fragPos);
     float attenuation = 1.0 / (pointLight.constant + pointLight.linear * distance + pointLight.quadratic * (distance * distance));
 
     vec3 ambient = pointLight.ambient * GetDiffuseTexel();
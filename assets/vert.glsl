@@ -3,19 +3,35 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 uniform mat3 normalModel;
 
+#ifdef QUANTIZED_VERTICES
+// Quantized positions are 16-bit offsets into the model's bounds
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+#endif
+
 out vec3 FragPos;
 out vec3 FragNorm;
 out vec2 TextCoords;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0f);
-    FragPos = vec3(model * vec4(aPos, 1.0));
+#ifdef QUANTIZED_VERTICES
+    vec3 position = positionOffset + aPos * positionScale;
+#else
+    vec3 position = aPos;
+#endif
+    gl_Position = projection * view * model * vec4(position, 1.0f);
+    FragPos = vec3(model * vec4(position, 1.0));
     FragNorm = normalModel * aNormal;   // FIXME: aNormal is passed in fine, but normalModel is cancelling it out????
     TextCoords = aTexCoords;
 }
\ No newline at end of file
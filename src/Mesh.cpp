@@ -1,73 +0,0 @@
-#include "Mesh.h"
-#include <GLFW/glfw3.h>
-
-Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures) : vertices(vertices), indices(indices), textures(textures)
-{
-	setupMesh();
-}
-
-void Mesh::draw(Shader& shader)
-{
-	unsigned int diffuseNr = 1;
-	unsigned int specularNr = 1;
-
-	// Count number of diffuse and specular textures respectfully
-	for (unsigned int i = 0; i < textures.size(); i++)
-	{
-		glActiveTexture(GL_TEXTURE0 + i);
-
-		std::string name = textures[i].type;
-		std::string number;
-
-		if (name == "texture_diffuse")
-			number = std::to_string(diffuseNr++);
-		else if (name == "texture_specular")
-			number = std::to_string(specularNr++);
-
-		std::string uniformName = "material." + name + number;
-
-		// Set sampler to correct texture unit
-		shader.setInt(uniformName.c_str(), i);
-		glBindTexture(GL_TEXTURE_2D, textures[i].id);
-	}
-
-	// Draw mesh
-	glBindVertexArray(VAO);
-	glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-	glBindVertexArray(0);
-
-	// Reset active texture
-	glActiveTexture(GL_TEXTURE0);
-}
-
-void Mesh::setupMesh()
-{
-	// Generate buffers
-	glGenVertexArrays(1, &VAO);
-	glGenBuffers(1, &VBO);
-	glGenBuffers(1, &EBO);
-
-	// Bind buffers
-	glBindVertexArray(VAO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-
-	// Buffer data
-	// NOTE: Memory of structs in C++ are consecutive like arrays. Therefore, we can reference the struct
-	// the same way we did with plain arrays!
-	//													|				|
-	//													V				V
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-	// Vertex position, normal, texture coord
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal)); // using offsetof to measure distance of bytes between Vertex and its member Normal
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
-
-	glBindVertexArray(0);
-}
-
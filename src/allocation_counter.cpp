@@ -0,0 +1,42 @@
+#include <atomic>
+#include "allocation_counter.h"
+
+static std::atomic<unsigned int> activeCounters{ 0 };
+static std::atomic<size_t> allocationCount{ 0 };
+static std::atomic<size_t> allocatedBytes{ 0 };
+
+static AllocationTotals currentTotals()
+{
+	AllocationTotals totals;
+	totals.allocations = allocationCount.load(std::memory_order_relaxed);
+	totals.bytes = allocatedBytes.load(std::memory_order_relaxed);
+	return totals;
+}
+
+AllocationCounter::AllocationCounter()
+{
+	activeCounters++;
+	start = currentTotals();
+}
+
+AllocationCounter::~AllocationCounter()
+{
+	activeCounters--;
+}
+
+AllocationTotals AllocationCounter::totals() const
+{
+	AllocationTotals now = currentTotals();
+	now.allocations -= start.allocations;
+	now.bytes -= start.bytes;
+	return now;
+}
+
+void recordAllocation(size_t bytes)
+{
+	if (activeCounters.load(std::memory_order_relaxed) > 0)
+	{
+		allocationCount.fetch_add(1, std::memory_order_relaxed);
+		allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+
+// Heap allocations made through operator new
+struct AllocationTotals {
+	size_t allocations = 0;
+	size_t bytes = 0;
+};
+
+/*
+	Counts every allocation made through global operator new while it is alive, temporaries
+	included, so regressions in code like the import path show up in numbers rather than only in
+	profiles.
+
+	Allocations are only seen by programs that link allocation_hook.cpp, which replaces the global
+	operator new and delete. Everywhere else the counter stays at zero and the program keeps its
+	own allocator. With the hook, outside of counters every allocation costs one relaxed atomic load.
+
+	Allocations are counted on all threads. That covers work the counted code hands to the thread
+	pool, but also anything unrelated that allocates at the same time, so count on an otherwise
+	idle process. Over-aligned allocations are not counted.
+*/
+class AllocationCounter
+{
+public:
+	// Constructor
+	AllocationCounter();
+	AllocationCounter(const AllocationCounter&) = delete;
+	AllocationCounter& operator=(const AllocationCounter&) = delete;
+	~AllocationCounter();
+
+	// Allocations since construction
+	AllocationTotals totals() const;
+
+private:
+	AllocationTotals start;
+};
+
+// Count an allocation of bytes with every live counter, called by allocation_hook.cpp
+void recordAllocation(size_t bytes);
@@ -0,0 +1,95 @@
+#include <cstdlib>
+#include <new>
+#include "allocation_counter.h"
+
+/*
+	Replacements of the global allocation functions that report every allocation to
+	AllocationCounter. Only linked into programs that measure allocations, such as
+	import_benchmark, so everything else keeps the standard library's allocator and the
+	sanitizers' checks of it.
+
+	Every form of new and delete is replaced, so memory from one is never released by the other.
+	Over-aligned forms are left alone, they never meet these.
+*/
+
+// Like the standard operator new, keep asking the new handler to free memory until it gives up
+static void* allocate(size_t size)
+{
+	for (;;)
+	{
+		void* memory = std::malloc(size ? size : 1);
+		if (memory)
+		{
+			recordAllocation(size);
+			return memory;
+		}
+
+		std::new_handler handler = std::get_new_handler();
+		if (!handler)
+			throw std::bad_alloc();
+		handler();
+	}
+}
+
+void* operator new(size_t size)
+{
+	return allocate(size);
+}
+
+void* operator new[](size_t size)
+{
+	return allocate(size);
+}
+
+// The nothrow forms are the throwing ones with the failure caught, as the standard defines them
+static void* allocateOrNull(size_t size) noexcept
+{
+	try
+	{
+		return allocate(size);
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return allocateOrNull(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return allocateOrNull(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
@@ -0,0 +1,93 @@
+#include <cmath>
+#include "bounds.h"
+
+void AABB::grow(const glm::vec3& point)
+{
+	min = glm::min(min, point);
+	max = glm::max(max, point);
+}
+
+void AABB::grow(const AABB& box)
+{
+	min = glm::min(min, box.min);
+	max = glm::max(max, box.max);
+}
+
+// Transform the center and project the rotated extents back onto the axes
+AABB AABB::transformed(const glm::mat4& transform) const
+{
+	if (isEmpty())
+		return *this;
+
+	glm::vec3 newCenter = glm::vec3(transform * glm::vec4(center(), 1.f));
+	glm::vec3 e = extents();
+	glm::vec3 newExtents = glm::abs(glm::vec3(transform[0])) * e.x + glm::abs(glm::vec3(transform[1])) * e.y + glm::abs(glm::vec3(transform[2])) * e.z;
+
+	AABB box;
+	box.min = newCenter - newExtents;
+	box.max = newCenter + newExtents;
+	return box;
+}
+
+bool AABB::intersectsSphere(const glm::vec3& sphereCenter, float radius) const
+{
+	glm::vec3 closest = glm::clamp(sphereCenter, min, max);
+	glm::vec3 offset = sphereCenter - closest;
+	return glm::dot(offset, offset) <= radius * radius;
+}
+
+// Gribb/Hartmann plane extraction from the rows of the combined matrix
+Frustum::Frustum(const glm::mat4& viewProjection)
+{
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; i++)
+		rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+	planes[0] = rows[3] + rows[0];	// Left
+	planes[1] = rows[3] - rows[0];	// Right
+	planes[2] = rows[3] + rows[1];	// Bottom
+	planes[3] = rows[3] - rows[1];	// Top
+	planes[4] = rows[3] + rows[2];	// Near
+	planes[5] = rows[3] - rows[2];	// Far
+
+	for (glm::vec4& plane : planes)
+		plane /= glm::length(glm::vec3(plane));
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const
+{
+	for (const glm::vec4& plane : planes)
+	{
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+			return false;
+	}
+	return true;
+}
+
+// Conservative: only rejects boxes fully behind one plane
+bool Frustum::intersectsAABB(const AABB& box) const
+{
+	glm::vec3 center = box.center();
+	glm::vec3 extents = box.extents();
+	for (const glm::vec4& plane : planes)
+	{
+		glm::vec3 normal = glm::vec3(plane);
+		float reach = glm::dot(glm::abs(normal), extents);
+		if (glm::dot(normal, center) + plane.w < -reach)
+			return false;
+	}
+	return true;
+}
+
+// A plane transforms as a row vector multiplied by the matrix that maps object to world space
+Frustum Frustum::inObjectSpace(const glm::mat4& modelMatrix) const
+{
+	Frustum frustum;
+	for (int i = 0; i < 6; i++)
+	{
+		const glm::vec4& plane = planes[i];
+		glm::vec4 objectPlane(glm::dot(plane, modelMatrix[0]), glm::dot(plane, modelMatrix[1]), glm::dot(plane, modelMatrix[2]), glm::dot(plane, modelMatrix[3]));
+		frustum.planes[i] = objectPlane / glm::length(glm::vec3(objectPlane));
+	}
+	return frustum;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cmath>
+#include <glm/glm.hpp>
+
+// Axis aligned bounding box. An empty box has min > max, so growing it by any point makes it valid.
+struct AABB
+{
+	glm::vec3 min = glm::vec3(INFINITY);
+	glm::vec3 max = glm::vec3(-INFINITY);
+
+	// Methods
+	bool isEmpty() const { return min.x > max.x; }
+	void grow(const glm::vec3& point);
+	void grow(const AABB& box);
+	glm::vec3 center() const { return (min + max) * .5f; }
+	glm::vec3 extents() const { return (max - min) * .5f; }
+
+	// Box around this box after transforming it
+	AABB transformed(const glm::mat4& transform) const;
+	bool intersectsSphere(const glm::vec3& center, float radius) const;
+};
+
+struct BoundingSphere
+{
+	glm::vec3 center = glm::vec3(0.f);
+	float radius = 0.f;
+};
+
+// The six planes of a view frustum, pointing inwards, as (normal, distance)
+struct Frustum
+{
+	glm::vec4 planes[6];
+
+	// Constructor
+	Frustum() = default;
+	Frustum(const glm::mat4& viewProjection);
+
+	// Methods
+	bool intersectsSphere(const glm::vec3& center, float radius) const;
+	bool intersectsAABB(const AABB& box) const;
+
+	// The same frustum in the object space of a model matrix, to test object space bounds without
+	// transforming them
+	Frustum inObjectSpace(const glm::mat4& modelMatrix) const;
+};
@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <cmath>
+#include "bvh.h"
+
+// Empty boxes (meshes without vertices) become a point at the origin, so they never poison a parent's bounds
+static AABB itemBox(const AABB& box)
+{
+	if (!box.isEmpty())
+		return box;
+
+	AABB point;
+	point.grow(glm::vec3(0.f));
+	return point;
+}
+
+void BVH::build(const std::vector<AABB>& bounds)
+{
+	nodes.clear();
+	items.resize(bounds.size());
+	itemBounds = PackedBounds();
+	if (bounds.empty())
+		return;
+
+	std::vector<glm::vec3> centroids(bounds.size());
+	for (unsigned int i = 0; i < bounds.size(); i++)
+	{
+		items[i] = i;
+		centroids[i] = itemBox(bounds[i]).center();
+	}
+
+	// A binary tree with at most one item per leaf has 2n - 1 nodes
+	nodes.reserve(bounds.size() * 2);
+	buildNode(bounds, centroids, 0, static_cast<unsigned int>(bounds.size()));
+
+	// Lay out the item bounds in tree order, so every leaf tests a contiguous range
+	for (unsigned int item : items)
+	{
+		AABB box = itemBox(bounds[item]);
+		glm::vec3 center = box.center();
+		glm::vec3 extents = box.extents();
+		itemBounds.centerX.push_back(center.x);
+		itemBounds.centerY.push_back(center.y);
+		itemBounds.centerZ.push_back(center.z);
+		itemBounds.extentX.push_back(extents.x);
+		itemBounds.extentY.push_back(extents.y);
+		itemBounds.extentZ.push_back(extents.z);
+	}
+}
+
+// Build the subtree over items[first, first + count) and return its node index
+unsigned int BVH::buildNode(const std::vector<AABB>& bounds, std::vector<glm::vec3>& centroids, unsigned int first, unsigned int count)
+{
+	unsigned int index = static_cast<unsigned int>(nodes.size());
+	nodes.push_back(BVHNode{ AABB(), first, count, 0 });
+
+	AABB nodeBounds, centroidBounds;
+	for (unsigned int i = first; i < first + count; i++)
+	{
+		nodeBounds.grow(itemBox(bounds[items[i]]));
+		centroidBounds.grow(centroids[items[i]]);
+	}
+	nodes[index].bounds = nodeBounds;
+
+	if (count <= LEAF_SIZE)
+		return index;
+
+	// Split at the median centroid along the axis the centroids spread the most
+	glm::vec3 spread = centroidBounds.max - centroidBounds.min;
+	int axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+	unsigned int half = count / 2;
+	std::nth_element(items.begin() + first, items.begin() + first + half, items.begin() + first + count, [&](unsigned int a, unsigned int b) {
+		return centroids[a][axis] < centroids[b][axis];
+	});
+
+	buildNode(bounds, centroids, first, half);
+	unsigned int right = buildNode(bounds, centroids, first + half, count - half);
+	nodes[index].rightChild = right;
+	return index;
+}
+
+// Set visible[item] for every item whose bounds intersect the frustum, and clear it for the others
+void BVH::cull(const Frustum& frustum, unsigned char* visible) const
+{
+	std::fill(visible, visible + items.size(), 0);
+	if (!nodes.empty())
+		cullNode(frustum, 0, 0x3F, visible);
+}
+
+// planeMask holds the planes the node's parent still straddles. A plane the node is fully in front
+// of is dropped for its whole subtree, and once none are left every item below is visible.
+void BVH::cullNode(const Frustum& frustum, unsigned int index, unsigned int planeMask, unsigned char* visible) const
+{
+	const BVHNode& node = nodes[index];
+	glm::vec3 center = node.bounds.center();
+	glm::vec3 extents = node.bounds.extents();
+
+	for (int i = 0; i < 6; i++)
+	{
+		if (!(planeMask & (1u << i)))
+			continue;
+
+		const glm::vec4& plane = frustum.planes[i];
+		glm::vec3 normal = glm::vec3(plane);
+		float distance = glm::dot(normal, center) + plane.w;
+		float reach = glm::dot(glm::abs(normal), extents);
+		if (distance + reach < 0.f)
+			return;
+		if (distance - reach >= 0.f)
+			planeMask &= ~(1u << i);
+	}
+
+	if (planeMask == 0)
+	{
+		for (unsigned int i = node.firstItem; i < node.firstItem + node.itemCount; i++)
+			visible[items[i]] = 1;
+		return;
+	}
+	if (node.isLeaf())
+	{
+		cullItems(frustum, node, planeMask, visible);
+		return;
+	}
+	cullNode(frustum, index + 1, planeMask, visible);
+	cullNode(frustum, node.rightChild, planeMask, visible);
+}
+
+// Test a leaf's items against the remaining planes, over its contiguous range of packed bounds
+void BVH::cullItems(const Frustum& frustum, const BVHNode& leaf, unsigned int planeMask, unsigned char* visible) const
+{
+	unsigned char inside[LEAF_SIZE];
+	std::fill(inside, inside + LEAF_SIZE, 1);
+
+	unsigned int first = leaf.firstItem;
+	const float* centerX = itemBounds.centerX.data() + first;
+	const float* centerY = itemBounds.centerY.data() + first;
+	const float* centerZ = itemBounds.centerZ.data() + first;
+	const float* extentX = itemBounds.extentX.data() + first;
+	const float* extentY = itemBounds.extentY.data() + first;
+	const float* extentZ = itemBounds.extentZ.data() + first;
+
+	for (int p = 0; p < 6; p++)
+	{
+		if (!(planeMask & (1u << p)))
+			continue;
+
+		const glm::vec4& plane = frustum.planes[p];
+		float nx = plane.x, ny = plane.y, nz = plane.z, w = plane.w;
+		float ax = std::abs(nx), ay = std::abs(ny), az = std::abs(nz);
+		for (unsigned int i = 0; i < leaf.itemCount; i++)
+		{
+			float distance = nx * centerX[i] + ny * centerY[i] + nz * centerZ[i] + w;
+			float reach = ax * extentX[i] + ay * extentY[i] + az * extentZ[i];
+			inside[i] &= static_cast<unsigned char>(distance + reach >= 0.f);
+		}
+	}
+
+	for (unsigned int i = 0; i < leaf.itemCount; i++)
+		visible[items[first + i]] = inside[i];
+}
+
+// Nearest item whose bounds the ray hits within maxDistance. Children are visited near to far, and
+// subtrees that start behind the closest hit so far are skipped.
+bool BVH::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, unsigned int& item, float& distance) const
+{
+	if (nodes.empty())
+		return false;
+
+	glm::vec3 inverseDirection = 1.f / direction;
+	float closest = maxDistance;
+	bool hit = false;
+
+	std::vector<unsigned int> stack;
+	if (intersectRayAABB(origin, inverseDirection, nodes[0].bounds, closest) >= 0.f)
+		stack.push_back(0);
+
+	while (!stack.empty())
+	{
+		const BVHNode& node = nodes[stack.back()];
+		stack.pop_back();
+		if (intersectRayAABB(origin, inverseDirection, node.bounds, closest) < 0.f)
+			continue;
+
+		if (node.isLeaf())
+		{
+			for (unsigned int i = node.firstItem; i < node.firstItem + node.itemCount; i++)
+			{
+				glm::vec3 center(itemBounds.centerX[i], itemBounds.centerY[i], itemBounds.centerZ[i]);
+				glm::vec3 extents(itemBounds.extentX[i], itemBounds.extentY[i], itemBounds.extentZ[i]);
+				AABB box;
+				box.min = center - extents;
+				box.max = center + extents;
+
+				float t = intersectRayAABB(origin, inverseDirection, box, closest);
+				if (t >= 0.f)
+				{
+					closest = t;
+					item = items[i];
+					hit = true;
+				}
+			}
+			continue;
+		}
+
+		// Push the farther child first so the nearer one is popped next
+		unsigned int left = static_cast<unsigned int>(&node - nodes.data()) + 1;
+		unsigned int right = node.rightChild;
+		float leftDistance = intersectRayAABB(origin, inverseDirection, nodes[left].bounds, closest);
+		float rightDistance = intersectRayAABB(origin, inverseDirection, nodes[right].bounds, closest);
+		if (leftDistance >= 0.f && rightDistance >= 0.f)
+		{
+			stack.push_back(leftDistance < rightDistance ? right : left);
+			stack.push_back(leftDistance < rightDistance ? left : right);
+		}
+		else if (leftDistance >= 0.f)
+			stack.push_back(left);
+		else if (rightDistance >= 0.f)
+			stack.push_back(right);
+	}
+
+	if (hit)
+		distance = closest;
+	return hit;
+}
+
+// Slab test. A ray starting inside the box enters it at distance 0.
+float intersectRayAABB(const glm::vec3& origin, const glm::vec3& inverseDirection, const AABB& box, float maxDistance)
+{
+	glm::vec3 t0 = (box.min - origin) * inverseDirection;
+	glm::vec3 t1 = (box.max - origin) * inverseDirection;
+	glm::vec3 tMin = glm::min(t0, t1);
+	glm::vec3 tMax = glm::max(t0, t1);
+
+	float enter = std::max({ tMin.x, tMin.y, tMin.z, 0.f });
+	float exit = std::min({ tMax.x, tMax.y, tMax.z, maxDistance });
+	return enter <= exit ? enter : -1.f;
+}
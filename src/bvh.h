@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "bounds.h"
+
+// Object space bounds of items as separate center and extent arrays, so frustum tests run over
+// contiguous floats and vectorize
+struct PackedBounds {
+	std::vector<float> centerX, centerY, centerZ;
+	std::vector<float> extentX, extentY, extentZ;
+};
+
+// Every node covers a contiguous range of the BVH's item order. Inner nodes have their left child
+// right after them and the right child at rightChild; leaves have rightChild == 0.
+struct BVHNode {
+	AABB bounds;
+	unsigned int firstItem;
+	unsigned int itemCount;
+	unsigned int rightChild;
+
+	bool isLeaf() const { return rightChild == 0; }
+};
+
+/*
+	Bounding volume hierarchy over a set of boxes, built top down by splitting at the median
+	centroid along the longest axis. Culling and ray casts visit O(log n) nodes for scenes where
+	most items are far from the camera or the ray, instead of testing every item.
+
+	Items keep the index they were built with; itemAt() maps a position in the tree order back to it.
+*/
+class BVH
+{
+public:
+	// Methods
+	void build(const std::vector<AABB>& itemBounds);
+	void cull(const Frustum& frustum, unsigned char* visible) const;
+	bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, unsigned int& item, float& distance) const;
+
+	bool isEmpty() const { return nodes.empty(); }
+	const std::vector<BVHNode>& getNodes() const { return nodes; }
+	unsigned int itemAt(unsigned int position) const { return items[position]; }
+
+	// Largest number of items in a leaf
+	static const unsigned int LEAF_SIZE = 4;
+
+private:
+	std::vector<BVHNode> nodes;
+	std::vector<unsigned int> items;	// Item indices in tree order
+	PackedBounds itemBounds;		// Item bounds in tree order
+
+	unsigned int buildNode(const std::vector<AABB>& bounds, std::vector<glm::vec3>& centroids, unsigned int first, unsigned int count);
+	void cullNode(const Frustum& frustum, unsigned int node, unsigned int planeMask, unsigned char* visible) const;
+	void cullItems(const Frustum& frustum, const BVHNode& leaf, unsigned int planeMask, unsigned char* visible) const;
+};
+
+// Distance along the ray to where it enters the box, or a negative value if it misses
+float intersectRayAABB(const glm::vec3& origin, const glm::vec3& inverseDirection, const AABB& box, float maxDistance);
@@ -70,6 +70,15 @@ void Camera::lookAtPosition(glm::vec3 position)
     updateCameraVectors();
 }
 
+// Set yaw and pitch directly, e.g. from a scripted camera path
+void Camera::setOrientation(float yaw, float pitch)
+{
+    this->yaw = yaw;
+    this->pitch = pitch;
+
+    updateCameraVectors();
+}
+
 glm::mat4 Camera::getViewMatrix() const
 {
     glm::mat4 translation = glm::mat4(
@@ -87,6 +96,12 @@ glm::mat4 Camera::getViewMatrix() const
     return rotation * translation;
 }
 
+// Frustum of this view for the projection the scene is rendered with, in world space
+Frustum Camera::getFrustum(const glm::mat4& projection) const
+{
+    return Frustum(projection * getViewMatrix());
+}
+
 glm::vec3 Camera::getFront() const
 {
     return front;
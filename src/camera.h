@@ -5,6 +5,7 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include "bounds.h"
 
 enum Camera_Movement
 {
@@ -42,7 +43,9 @@ class Camera
 
     // Methods
     void lookAtPosition(glm::vec3 position);
+    void setOrientation(float yaw, float pitch);
     glm::mat4 getViewMatrix() const;
+    Frustum getFrustum(const glm::mat4& projection) const;
     glm::vec3 getFront() const;
     float getSpeed() const;
 
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <glm/gtc/constants.hpp>
+#include "camera_path.h"
+
+// Read keyframes from a text file. Nothing is kept if any line is malformed.
+bool CameraPath::load(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		std::cout << "ERROR::CAMERA_PATH::Could not open " << path << std::endl;
+		return false;
+	}
+
+	std::vector<CameraKeyframe> loaded;
+	std::string line;
+	for (unsigned int lineNumber = 1; std::getline(file, line); lineNumber++)
+	{
+		size_t start = line.find_first_not_of(" \t\r");
+		if (start == std::string::npos || line[start] == '#')
+			continue;
+
+		std::istringstream fields(line);
+		CameraKeyframe keyframe;
+		if (!(fields >> keyframe.time >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z >> keyframe.yaw >> keyframe.pitch >> keyframe.fov))
+		{
+			std::cout << "ERROR::CAMERA_PATH::Malformed keyframe at " << path << ":" << lineNumber << std::endl;
+			return false;
+		}
+		loaded.push_back(keyframe);
+	}
+
+	keyframes.clear();
+	for (const CameraKeyframe& keyframe : loaded)
+		addKeyframe(keyframe);
+	return true;
+}
+
+// Insert a keyframe, keeping them sorted by time
+void CameraPath::addKeyframe(const CameraKeyframe& keyframe)
+{
+	auto position = std::upper_bound(keyframes.begin(), keyframes.end(), keyframe.time, [](float time, const CameraKeyframe& other) {
+		return time < other.time;
+	});
+	keyframes.insert(position, keyframe);
+}
+
+// Move the camera to where the path is at time
+void CameraPath::apply(float time, Camera& camera) const
+{
+	if (keyframes.empty())
+		return;
+
+	auto next = std::upper_bound(keyframes.begin(), keyframes.end(), time, [](float time, const CameraKeyframe& keyframe) {
+		return time < keyframe.time;
+	});
+	const CameraKeyframe& a = next == keyframes.begin() ? *next : *(next - 1);
+	const CameraKeyframe& b = next == keyframes.end() ? keyframes.back() : *next;
+
+	float span = b.time - a.time;
+	float t = span > 0.f ? glm::clamp((time - a.time) / span, 0.f, 1.f) : 0.f;
+	camera.position = glm::mix(a.position, b.position, t);
+	camera.fov = glm::mix(a.fov, b.fov, t);
+	camera.setOrientation(glm::mix(a.yaw, b.yaw, t), glm::mix(a.pitch, b.pitch, t));
+}
+
+CameraPath CameraPath::makeOrbit(const glm::vec3& center, float radius, float height, float duration, unsigned int steps)
+{
+	CameraPath path;
+	float pitch = glm::degrees(std::atan2(-height, radius));
+	for (unsigned int i = 0; i <= steps; i++)
+	{
+		// Camera yaw points from the camera back to the center, half a turn from its angle on the circle
+		float angle = glm::radians(90.f) + glm::two_pi<float>() * i / steps;
+		CameraKeyframe keyframe;
+		keyframe.time = duration * i / steps;
+		keyframe.position = center + glm::vec3(radius * std::cos(angle), height, radius * std::sin(angle));
+		keyframe.yaw = glm::degrees(angle) + 180.f;
+		keyframe.pitch = pitch;
+		path.addKeyframe(keyframe);
+	}
+	return path;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "camera.h"
+
+/*
+	Scripted camera for runs without input. A path is a list of keyframes sorted by time, and the
+	camera is linearly interpolated between the two around the current time. Before the first and
+	after the last keyframe it holds still.
+
+	Paths are loaded from text files with one keyframe per line, blank lines and lines starting
+	with # are skipped:
+
+		# time  x y z  yaw pitch  fov
+		0       0 0 3  -90 0      45
+		5       3 1 0  -180 -10   45
+
+	Yaw and pitch are in degrees, like Camera's. Yaw is interpolated as given, without wrapping.
+*/
+struct CameraKeyframe {
+	float time = 0.f;
+	glm::vec3 position = glm::vec3(0.f);
+	float yaw = -90.f;
+	float pitch = 0.f;
+	float fov = 45.f;
+};
+
+class CameraPath
+{
+public:
+	// Methods
+	bool load(const std::string& path);
+	void addKeyframe(const CameraKeyframe& keyframe);
+	void apply(float time, Camera& camera) const;
+	bool empty() const { return keyframes.empty(); }
+	float getDuration() const { return keyframes.empty() ? 0.f : keyframes.back().time; }
+	const std::vector<CameraKeyframe>& getKeyframes() const { return keyframes; }
+
+	// Circle around center at the given radius and height, once every duration seconds
+	static CameraPath makeOrbit(const glm::vec3& center, float radius, float height, float duration, unsigned int steps = 32);
+
+private:
+	std::vector<CameraKeyframe> keyframes;
+};
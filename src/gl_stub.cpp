@@ -0,0 +1,117 @@
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <glad/glad.h>
+#include "gl_stub.h"
+
+#if defined(_WIN32) && !defined(_WIN64)
+#error "The GL stubs need a caller cleaned calling convention, 32-bit Windows is not supported"
+#endif
+
+static std::atomic<GLuint> nextName{ 1 };
+
+static GLuint64 APIENTRY stubZero()
+{
+	return 0;
+}
+
+static const GLubyte* APIENTRY stubGetString(GLenum name)
+{
+	return reinterpret_cast<const GLubyte*>(name == GL_VERSION ? "3.3.0 stub" : "stub");
+}
+
+static const GLubyte* APIENTRY stubGetStringi(GLenum, GLuint)
+{
+	return reinterpret_cast<const GLubyte*>("");
+}
+
+static void APIENTRY stubGenNames(GLsizei n, GLuint* names)
+{
+	for (GLsizei i = 0; i < n; i++)
+		names[i] = nextName++;
+}
+
+static GLuint APIENTRY stubCreateName()
+{
+	return nextName++;
+}
+
+static GLuint APIENTRY stubCreateShader(GLenum)
+{
+	return nextName++;
+}
+
+static void APIENTRY stubGetIntegerv(GLenum, GLint* data)
+{
+	*data = 0;
+}
+
+static void APIENTRY stubGetInteger64v(GLenum, GLint64* data)
+{
+	*data = 0;
+}
+
+static void APIENTRY stubGetFloatv(GLenum, GLfloat* data)
+{
+	*data = 0.f;
+}
+
+static void APIENTRY stubGetBooleanv(GLenum, GLboolean* data)
+{
+	*data = GL_FALSE;
+}
+
+// Compile and link status report success, everything else, like info log lengths, is 0
+static void APIENTRY stubGetObjectiv(GLuint, GLenum pname, GLint* params)
+{
+	*params = pname == GL_COMPILE_STATUS || pname == GL_LINK_STATUS ? GL_TRUE : 0;
+}
+
+static void APIENTRY stubGetQueryObjectuiv(GLuint, GLenum, GLuint* params)
+{
+	*params = 0;
+}
+
+static void APIENTRY stubGetQueryObjectui64v(GLuint, GLenum, GLuint64* params)
+{
+	*params = 0;
+}
+
+static GLenum APIENTRY stubCheckFramebufferStatus(GLenum)
+{
+	return GL_FRAMEBUFFER_COMPLETE;
+}
+
+static void* stubGetProcAddress(const char* name)
+{
+	static const std::unordered_map<std::string, void*> stubs = {
+		{ "glGetString", reinterpret_cast<void*>(&stubGetString) },
+		{ "glGetStringi", reinterpret_cast<void*>(&stubGetStringi) },
+		{ "glGenBuffers", reinterpret_cast<void*>(&stubGenNames) },
+		{ "glGenFramebuffers", reinterpret_cast<void*>(&stubGenNames) },
+		{ "glGenQueries", reinterpret_cast<void*>(&stubGenNames) },
+		{ "glGenRenderbuffers", reinterpret_cast<void*>(&stubGenNames) },
+		{ "glGenTextures", reinterpret_cast<void*>(&stubGenNames) },
+		{ "glGenVertexArrays", reinterpret_cast<void*>(&stubGenNames) },
+		{ "glCreateProgram", reinterpret_cast<void*>(&stubCreateName) },
+		{ "glCreateShader", reinterpret_cast<void*>(&stubCreateShader) },
+		{ "glGetIntegerv", reinterpret_cast<void*>(&stubGetIntegerv) },
+		{ "glGetInteger64v", reinterpret_cast<void*>(&stubGetInteger64v) },
+		{ "glGetFloatv", reinterpret_cast<void*>(&stubGetFloatv) },
+		{ "glGetBooleanv", reinterpret_cast<void*>(&stubGetBooleanv) },
+		{ "glGetShaderiv", reinterpret_cast<void*>(&stubGetObjectiv) },
+		{ "glGetProgramiv", reinterpret_cast<void*>(&stubGetObjectiv) },
+		{ "glGetQueryObjectuiv", reinterpret_cast<void*>(&stubGetQueryObjectuiv) },
+		{ "glGetQueryObjectui64v", reinterpret_cast<void*>(&stubGetQueryObjectui64v) },
+		{ "glCheckFramebufferStatus", reinterpret_cast<void*>(&stubCheckFramebufferStatus) },
+	};
+
+	auto it = stubs.find(name);
+	return it != stubs.end() ? it->second : reinterpret_cast<void*>(&stubZero);
+}
+
+bool loadStubGL()
+{
+	return gladLoadGLLoader(stubGetProcAddress) != 0;
+}
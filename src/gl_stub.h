@@ -0,0 +1,12 @@
+#pragma once
+
+/*
+	Loads glad with entry points that do nothing, so code that calls GL can run without a context or
+	a GPU, for benchmarks of the CPU side of loading. Object names are handed out in sequence,
+	shaders always compile, framebuffers are always complete and every other query returns zero.
+
+	Every entry point without an explicit stub returns 0 and ignores its arguments, which relies on
+	the caller cleaning up the stack. That holds for every 64-bit calling convention, but not for
+	32-bit Windows, where APIENTRY is __stdcall.
+*/
+bool loadStubGL();
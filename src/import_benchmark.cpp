@@ -0,0 +1,430 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include "gl_stub.h"
+#include "model.h"
+#include "model_cache.h"
+#include "model_import.h"
+#include "texture_loader.h"
+
+/*
+	Times the stages of loading a model on their own, with GL stubbed out so no GPU or window is
+	needed:
+
+		import_benchmark [--max-vertices <count>] [--min-time <seconds>] [--filter <text>]
+		                 [--model <file>]... [--csv <file>]
+
+	Synthetic scenes scale processMesh from 1K to 10M vertices in one mesh, and processNode,
+	processMesh and loadMaterialTextures from 1 to 10K small meshes. The bundled assets, and any
+	--model files, go through Assimp's ReadFile, the whole of importModel, the texture loader and
+	the Model constructor, once without and once with its mesh cache.
+
+	Every case runs until it took --min-time seconds in total, and reports its median iteration
+	with throughput in vertices and megabytes per second. Only stages the filter text appears in
+	are run. The 10M vertex case needs a few gigabytes of memory, --max-vertices skips the larger
+	sizes.
+*/
+
+#ifdef PROJECT_ROOT_DIR
+
+// Constants
+const std::string ASSET_DIRECTORY = std::string(PROJECT_ROOT_DIR) + "/assets/";
+const size_t SYNTHETIC_VERTEX_COUNTS[] = { 1000, 10000, 100000, 1000000, 10000000 };
+const unsigned int SYNTHETIC_MESH_COUNTS[] = { 1, 10, 100, 1000, 10000 };
+const size_t SYNTHETIC_MESH_VERTICES = 256;		// Vertices of every mesh in the mesh count cases
+const unsigned int SYNTHETIC_MATERIAL_COUNT = 16;
+const unsigned int MAX_ITERATIONS = 1000;
+
+struct BenchmarkOptions {
+	size_t maxVertices = 10000000;
+	double minSeconds = 1.0;
+	std::string filter;
+	std::vector<std::string> modelPaths = { ASSET_DIRECTORY + "brick_cylinder.obj", ASSET_DIRECTORY + "backpack.obj" };
+	std::string csvPath;
+};
+
+struct StageResult {
+	std::string stage;
+	std::string input;
+	unsigned int iterations = 0;
+	double medianSeconds = 0.0;
+	double minSeconds = 0.0;
+	size_t vertices = 0;	// Processed by one iteration, 0 for stages that don't work on vertices
+	size_t bytes = 0;		// Read or produced by one iteration
+};
+
+BenchmarkOptions options;
+std::vector<StageResult> results;
+
+bool parseArguments(int argc, char** argv);
+void benchmarkSyntheticVertices(size_t vertexCount);
+void benchmarkSyntheticMeshes(unsigned int meshCount);
+void benchmarkFile(const std::string& path);
+void printResult(const StageResult& result);
+bool writeCsv(const std::string& path);
+
+int main(int argc, char** argv)
+{
+	if (!parseArguments(argc, argv))
+		return EXIT_FAILURE;
+
+	if (!loadStubGL())
+	{
+		std::cout << "ERROR::IMPORT_BENCHMARK::Could not load the GL stubs" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::printf("%-28s %-28s %6s %12s %12s %10s %10s\n", "Stage", "Input", "Runs", "Median ms", "Min ms", "Mvert/s", "MB/s");
+	for (size_t vertexCount : SYNTHETIC_VERTEX_COUNTS)
+	{
+		if (vertexCount <= options.maxVertices)
+			benchmarkSyntheticVertices(vertexCount);
+	}
+	for (unsigned int meshCount : SYNTHETIC_MESH_COUNTS)
+	{
+		if (meshCount * SYNTHETIC_MESH_VERTICES <= options.maxVertices)
+			benchmarkSyntheticMeshes(meshCount);
+	}
+	for (const std::string& path : options.modelPaths)
+		benchmarkFile(path);
+
+	if (!options.csvPath.empty() && !writeCsv(options.csvPath))
+		return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
+
+bool parseArguments(int argc, char** argv)
+{
+	bool customModels = false;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (argument == "--max-vertices" && hasValue)
+			options.maxVertices = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+		else if (argument == "--min-time" && hasValue)
+			options.minSeconds = std::strtod(argv[++i], nullptr);
+		else if (argument == "--filter" && hasValue)
+			options.filter = argv[++i];
+		else if (argument == "--csv" && hasValue)
+			options.csvPath = argv[++i];
+		else if (argument == "--model" && hasValue)
+		{
+			// Models given on the command line replace the bundled ones
+			if (!customModels)
+				options.modelPaths.clear();
+			customModels = true;
+			options.modelPaths.push_back(argv[++i]);
+		}
+		else
+		{
+			std::cout << "Usage: import_benchmark [--max-vertices <count>] [--min-time <seconds>] [--filter <text>]\n"
+				<< "                        [--model <file>]... [--csv <file>]\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+// Run a stage until it took minSeconds in total. setup runs before every iteration and is not timed.
+static void measure(const std::string& stage, const std::string& input, size_t vertices, size_t bytes, const std::function<void()>& setup,
+	const std::function<void()>& run)
+{
+	if (!options.filter.empty() && stage.find(options.filter) == std::string::npos)
+		return;
+
+	std::vector<double> times;
+	double total = 0.0;
+	while (times.empty() || (total < options.minSeconds && times.size() < MAX_ITERATIONS))
+	{
+		if (setup)
+			setup();
+		auto start = std::chrono::steady_clock::now();
+		run();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		times.push_back(seconds);
+		total += seconds;
+	}
+	std::sort(times.begin(), times.end());
+
+	StageResult result;
+	result.stage = stage;
+	result.input = input;
+	result.iterations = static_cast<unsigned int>(times.size());
+	result.medianSeconds = times[times.size() / 2];
+	result.minSeconds = times.front();
+	result.vertices = vertices;
+	result.bytes = bytes;
+	printResult(result);
+	results.push_back(result);
+}
+
+// A square grid mesh of about vertexCount vertices over a gentle wave, so it isn't flat
+static aiMesh* makeGridMesh(size_t vertexCount, unsigned int materialIndex)
+{
+	unsigned int side = std::max(2u, static_cast<unsigned int>(std::lround(std::sqrt(static_cast<double>(vertexCount)))));
+	aiMesh* mesh = new aiMesh();
+	mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+	mesh->mMaterialIndex = materialIndex;
+	mesh->mNumVertices = side * side;
+	mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+	mesh->mNormals = new aiVector3D[mesh->mNumVertices];
+	mesh->mTextureCoords[0] = new aiVector3D[mesh->mNumVertices];
+	mesh->mNumUVComponents[0] = 2;
+
+	for (unsigned int z = 0; z < side; z++)
+	{
+		for (unsigned int x = 0; x < side; x++)
+		{
+			unsigned int i = z * side + x;
+			float u = static_cast<float>(x) / (side - 1), v = static_cast<float>(z) / (side - 1);
+			mesh->mVertices[i] = aiVector3D(u, .05f * std::sin(u * 20.f) * std::cos(v * 20.f), v);
+			mesh->mNormals[i] = aiVector3D(0.f, 1.f, 0.f);
+			mesh->mTextureCoords[0][i] = aiVector3D(u, v, 0.f);
+		}
+	}
+
+	mesh->mNumFaces = 2 * (side - 1) * (side - 1);
+	mesh->mFaces = new aiFace[mesh->mNumFaces];
+	unsigned int face = 0;
+	for (unsigned int z = 0; z + 1 < side; z++)
+	{
+		for (unsigned int x = 0; x + 1 < side; x++)
+		{
+			unsigned int corner = z * side + x;
+			const unsigned int triangles[2][3] = {
+				{ corner, corner + side, corner + 1 },
+				{ corner + 1, corner + side, corner + side + 1 }
+			};
+			for (const unsigned int* triangle : triangles)
+			{
+				aiFace& f = mesh->mFaces[face++];
+				f.mNumIndices = 3;
+				f.mIndices = new unsigned int[3]{ triangle[0], triangle[1], triangle[2] };
+			}
+		}
+	}
+	return mesh;
+}
+
+// Scene like a typical OBJ import: meshCount grid meshes, each under its own node below the root,
+// sharing a few materials with a diffuse and a specular texture each
+static aiScene* makeSyntheticScene(size_t verticesPerMesh, unsigned int meshCount)
+{
+	aiScene* scene = new aiScene();
+	scene->mNumMaterials = std::min(meshCount, SYNTHETIC_MATERIAL_COUNT);
+	scene->mMaterials = new aiMaterial*[scene->mNumMaterials];
+	for (unsigned int i = 0; i < scene->mNumMaterials; i++)
+	{
+		scene->mMaterials[i] = new aiMaterial();
+		aiString diffuse("synthetic_diffuse_" + std::to_string(i) + ".png");
+		aiString specular("synthetic_specular_" + std::to_string(i) + ".png");
+		scene->mMaterials[i]->AddProperty(&diffuse, AI_MATKEY_TEXTURE_DIFFUSE(0));
+		scene->mMaterials[i]->AddProperty(&specular, AI_MATKEY_TEXTURE_SPECULAR(0));
+	}
+
+	scene->mNumMeshes = meshCount;
+	scene->mMeshes = new aiMesh*[meshCount];
+	scene->mRootNode = new aiNode("root");
+	scene->mRootNode->mNumChildren = meshCount;
+	scene->mRootNode->mChildren = new aiNode*[meshCount];
+	for (unsigned int i = 0; i < meshCount; i++)
+	{
+		scene->mMeshes[i] = makeGridMesh(verticesPerMesh, i % scene->mNumMaterials);
+
+		aiNode* node = new aiNode("mesh_" + std::to_string(i));
+		node->mParent = scene->mRootNode;
+		aiMatrix4x4::Translation(aiVector3D(static_cast<float>(i), 0.f, 0.f), node->mTransformation);
+		node->mNumMeshes = 1;
+		node->mMeshes = new unsigned int[1]{ i };
+		scene->mRootNode->mChildren[i] = node;
+	}
+	return scene;
+}
+
+static size_t countScene(const aiScene* scene, size_t& indexCount)
+{
+	size_t vertexCount = 0;
+	indexCount = 0;
+	for (unsigned int i = 0; i < scene->mNumMeshes; i++)
+	{
+		vertexCount += scene->mMeshes[i]->mNumVertices;
+		indexCount += static_cast<size_t>(scene->mMeshes[i]->mNumFaces) * 3;
+	}
+	return vertexCount;
+}
+
+// Flattened size of the vertices and indices, the data the import produces
+static size_t meshBytes(size_t vertexCount, size_t indexCount)
+{
+	return vertexCount * sizeof(Vertex) + indexCount * sizeof(unsigned int);
+}
+
+// processMesh on a single mesh of growing size
+void benchmarkSyntheticVertices(size_t vertexCount)
+{
+	std::unique_ptr<aiScene> scene(makeSyntheticScene(vertexCount, 1));
+	size_t indexCount;
+	size_t vertices = countScene(scene.get(), indexCount);
+	std::string input = "grid " + std::to_string(vertices) + " vertices";
+
+	MeshData data;
+	measure("processMesh", input, vertices, meshBytes(vertices, indexCount), nullptr, [&]() {
+		VertexCacheStats before, after;
+		data = processMesh(scene->mMeshes[0], glm::mat4(1.f), before, after);
+	});
+}
+
+// The per node and per mesh stages on a growing number of small meshes
+void benchmarkSyntheticMeshes(unsigned int meshCount)
+{
+	std::unique_ptr<aiScene> scene(makeSyntheticScene(SYNTHETIC_MESH_VERTICES, meshCount));
+	size_t indexCount;
+	size_t vertices = countScene(scene.get(), indexCount);
+	std::string input = std::to_string(meshCount) + " meshes";
+
+	std::vector<ModelNode> nodes;
+	std::vector<aiMesh*> sceneMeshes;
+	std::vector<unsigned int> meshNodes;
+	measure("processNode", input, 0, 0, [&]() { nodes.clear(); sceneMeshes.clear(); meshNodes.clear(); }, [&]() {
+		processNode(scene->mRootNode, -1, scene.get(), nodes, sceneMeshes, meshNodes);
+	});
+	if (nodes.empty())
+		processNode(scene->mRootNode, -1, scene.get(), nodes, sceneMeshes, meshNodes);
+
+	// Serially, to time the stage rather than the thread pool
+	std::vector<MeshData> meshData(sceneMeshes.size());
+	measure("processMesh", input, vertices, meshBytes(vertices, indexCount), nullptr, [&]() {
+		for (size_t i = 0; i < sceneMeshes.size(); i++)
+		{
+			VertexCacheStats before, after;
+			meshData[i] = processMesh(sceneMeshes[i], nodes[meshNodes[i]].worldTransform, before, after);
+		}
+	});
+
+	std::vector<TextureRef> textures;
+	measure("loadMaterialTextures", input, 0, 0, [&]() { textures.clear(); }, [&]() {
+		for (unsigned int i = 0; i < scene->mNumMeshes; i++)
+		{
+			aiMaterial* material = scene->mMaterials[scene->mMeshes[i]->mMaterialIndex];
+			std::vector<TextureRef> diffuse = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
+			std::vector<TextureRef> specular = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
+			textures.insert(textures.end(), diffuse.begin(), diffuse.end());
+			textures.insert(textures.end(), specular.begin(), specular.end());
+		}
+	});
+}
+
+// Every stage of loading a model file, from parsing to the (stubbed) upload
+void benchmarkFile(const std::string& path)
+{
+	std::error_code error;
+	size_t fileSize = static_cast<size_t>(std::filesystem::file_size(path, error));
+	std::string input = std::filesystem::path(path).filename().string();
+	if (error)
+	{
+		std::printf("%-28s %-28s not found, skipped\n", "-", input.c_str());
+		return;
+	}
+
+	measure("Assimp::ReadFile", input, 0, fileSize, nullptr, [&]() {
+		Assimp::Importer importer;
+		importer.ReadFile(path, MODEL_IMPORT_FLAGS);
+	});
+
+	ImportedModel imported;
+	if (!importModel(path, imported))
+		return;
+	const ImportStats stats = imported.stats;
+	measure("importModel", input, stats.vertexCount, fileSize, nullptr, [&]() {
+		importModel(path, imported);
+	});
+	std::printf("%-28s %-28s %zu allocations of %zu bytes\n", "importModel allocations", input.c_str(), stats.allocations, stats.bytesAllocated);
+
+	// What TextureFromFile does for every texture of the model, on a loader of its own so nothing is
+	// already registered, until every decode is uploaded
+	std::string directory = path.substr(0, path.find_last_of("/\\"));
+	std::vector<std::string> textureFiles;
+	size_t textureBytes = 0;
+	for (const MaterialData& material : imported.materials)
+	{
+		for (const TextureRef& ref : material.textures)
+		{
+			std::string filename = directory + '/' + ref.path;
+			if (std::find(textureFiles.begin(), textureFiles.end(), filename) != textureFiles.end())
+				continue;
+			textureFiles.push_back(filename);
+			size_t size = static_cast<size_t>(std::filesystem::file_size(filename, error));
+			if (!error)
+				textureBytes += size;
+		}
+	}
+	if (!textureFiles.empty())
+	{
+		measure("TextureLoader::load", input, 0, textureBytes, nullptr, [&]() {
+			TextureLoader loader;
+			for (const std::string& filename : textureFiles)
+				loader.load(filename);
+			loader.finishUploads();
+		});
+	}
+
+	// The whole constructor, importing from scratch and then mapping the cache the first run wrote
+	std::string cachePath = modelCachePath(path);
+	measure("Model (import)", input, stats.vertexCount, fileSize, [&]() { std::filesystem::remove(cachePath, error); }, [&]() {
+		Model model(path);
+	});
+	if (!std::filesystem::exists(cachePath))
+	{
+		Model model(path);
+	}
+	measure("Model (cached)", input, stats.vertexCount, static_cast<size_t>(std::filesystem::file_size(cachePath, error)), nullptr, [&]() {
+		Model model(path);
+	});
+	TextureLoader::shared().finishUploads();
+}
+
+void printResult(const StageResult& result)
+{
+	char vertexRate[16] = "-", byteRate[16] = "-";
+	if (result.vertices && result.medianSeconds > 0.0)
+		std::snprintf(vertexRate, sizeof(vertexRate), "%.2f", result.vertices / result.medianSeconds / 1e6);
+	if (result.bytes && result.medianSeconds > 0.0)
+		std::snprintf(byteRate, sizeof(byteRate), "%.1f", result.bytes / result.medianSeconds / (1024.0 * 1024.0));
+	std::printf("%-28s %-28s %6u %12.3f %12.3f %10s %10s\n", result.stage.c_str(), result.input.c_str(), result.iterations,
+		result.medianSeconds * 1e3, result.minSeconds * 1e3, vertexRate, byteRate);
+	std::fflush(stdout);
+}
+
+bool writeCsv(const std::string& path)
+{
+	std::ofstream file(path);
+	if (!file)
+	{
+		std::cout << "ERROR::IMPORT_BENCHMARK::Could not write " << path << std::endl;
+		return false;
+	}
+
+	file << "stage,input,iterations,median_ms,min_ms,vertices,bytes,vertices_per_second,megabytes_per_second\n";
+	for (const StageResult& result : results)
+	{
+		double seconds = result.medianSeconds > 0.0 ? result.medianSeconds : 1.0;
+		file << result.stage << ',' << result.input << ',' << result.iterations << ',' << result.medianSeconds * 1e3 << ','
+			<< result.minSeconds * 1e3 << ',' << result.vertices << ',' << result.bytes << ',' << result.vertices / seconds << ','
+			<< result.bytes / seconds / (1024.0 * 1024.0) << '\n';
+	}
+	return static_cast<bool>(file);
+}
+
+#endif
@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <cmath>
+#include "light_clusters.h"
+
+// Upper bound of froxel light references per frame, so a pathological scene can't exhaust memory
+const size_t MAX_LIGHT_INDICES = 1 << 22;
+
+LightClusters::LightClusters(unsigned int tilesX, unsigned int tilesY, unsigned int slices)
+	: tilesX(tilesX), tilesY(tilesY), slices(slices), clusterBuffer(CLUSTER_BLOCK_BINDING, sizeof(ClusterBlock))
+{
+	lightGrid.resize(static_cast<size_t>(tilesX) * tilesY * slices * 2);
+
+	// Texture buffers holding the froxel light lists
+	glGenBuffers(1, &gridBuffer);
+	glGenTextures(1, &gridTexture);
+	glBindBuffer(GL_TEXTURE_BUFFER, gridBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, lightGrid.size() * sizeof(unsigned int), NULL, GL_STREAM_DRAW);
+	glBindTexture(GL_TEXTURE_BUFFER, gridTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, gridBuffer);
+
+	glGenBuffers(1, &indexBuffer);
+	glGenTextures(1, &indexTexture);
+	glBindBuffer(GL_TEXTURE_BUFFER, indexBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, sizeof(unsigned int), NULL, GL_STREAM_DRAW);
+	glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, indexBuffer);
+
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+// Bin the given lights into the froxels their spheres of influence overlap and upload the result
+void LightClusters::update(const glm::mat4& view, float fovY, float aspect, float nearPlane, float farPlane, int screenWidth, int screenHeight,
+	const std::vector<PointLight>& pointLights, const std::vector<unsigned int>& visibleLights)
+{
+	// Exponential depth slicing: slice = log(depth) * scale - bias, so slice 0 starts at the near plane
+	float logRatio = std::log(farPlane / nearPlane);
+	float sliceScale = slices / logRatio;
+	float sliceBias = slices * std::log(nearPlane) / logRatio;
+
+	// Projection scale in x and y, as in glm::perspective
+	float projY = 1.f / std::tan(fovY * .5f);
+	float projX = projY / aspect;
+
+	// Froxel range of every light
+	bounds.clear();
+	for (unsigned int i : visibleLights)
+	{
+		float radius = pointLights[i].radius;
+		if (radius <= 0.f)
+			continue;
+
+		glm::vec3 center = glm::vec3(view * glm::vec4(pointLights[i].position, 1.f));
+		float minDepth = -center.z - radius;
+		float maxDepth = -center.z + radius;
+		if (maxDepth < nearPlane || minDepth > farPlane)
+			continue;
+
+		LightBounds light;
+		light.light = i;
+
+		// Depth slices
+		auto slice = [&](float depth) {
+			float s = std::floor(std::log(std::max(depth, nearPlane)) * sliceScale - sliceBias);
+			return static_cast<unsigned int>(std::clamp(s, 0.f, static_cast<float>(slices - 1)));
+		};
+		light.minZ = slice(minDepth);
+		light.maxZ = slice(maxDepth);
+
+		// Screen tiles. A sphere crossing the near plane can cover any tile, otherwise project the
+		// corners of its bounding box, whose projection contains the sphere's.
+		float minX = -1.f, maxX = 1.f, minY = -1.f, maxY = 1.f;
+		if (minDepth > nearPlane)
+		{
+			minX = minY = INFINITY;
+			maxX = maxY = -INFINITY;
+			for (int corner = 0; corner < 8; corner++)
+			{
+				glm::vec3 point = center + glm::vec3(corner & 1 ? radius : -radius, corner & 2 ? radius : -radius, corner & 4 ? radius : -radius);
+				float x = projX * point.x / -point.z;
+				float y = projY * point.y / -point.z;
+				minX = std::min(minX, x);
+				maxX = std::max(maxX, x);
+				minY = std::min(minY, y);
+				maxY = std::max(maxY, y);
+			}
+			if (maxX < -1.f || minX > 1.f || maxY < -1.f || minY > 1.f)
+				continue;
+		}
+
+		auto tile = [](float ndc, unsigned int tiles) {
+			float t = std::floor((ndc * .5f + .5f) * tiles);
+			return static_cast<unsigned int>(std::clamp(t, 0.f, static_cast<float>(tiles - 1)));
+		};
+		light.minX = tile(minX, tilesX);
+		light.maxX = tile(maxX, tilesX);
+		light.minY = tile(minY, tilesY);
+		light.maxY = tile(maxY, tilesY);
+		bounds.push_back(light);
+	}
+
+	// Count lights per froxel, then turn the counts into offsets
+	std::fill(lightGrid.begin(), lightGrid.end(), 0u);
+	for (const LightBounds& light : bounds)
+	{
+		for (unsigned int z = light.minZ; z <= light.maxZ; z++)
+			for (unsigned int y = light.minY; y <= light.maxY; y++)
+				for (unsigned int x = light.minX; x <= light.maxX; x++)
+					lightGrid[((z * tilesY + y) * tilesX + x) * 2 + 1]++;
+	}
+
+	size_t total = 0;
+	for (size_t cluster = 0; cluster < lightGrid.size() / 2; cluster++)
+	{
+		size_t count = std::min<size_t>(lightGrid[cluster * 2 + 1], MAX_LIGHT_INDICES - total);
+		lightGrid[cluster * 2] = static_cast<unsigned int>(total);
+		lightGrid[cluster * 2 + 1] = 0;
+		total += count;
+	}
+
+	// Fill the index list, using the counts again as write cursors
+	lightIndices.resize(std::max<size_t>(total, 1));
+	for (const LightBounds& light : bounds)
+	{
+		for (unsigned int z = light.minZ; z <= light.maxZ; z++)
+			for (unsigned int y = light.minY; y <= light.maxY; y++)
+				for (unsigned int x = light.minX; x <= light.maxX; x++)
+				{
+					size_t cluster = (z * tilesY + y) * tilesX + x;
+					size_t next = cluster + 1 < lightGrid.size() / 2 ? lightGrid[(cluster + 1) * 2] : total;
+					unsigned int& count = lightGrid[cluster * 2 + 1];
+					if (lightGrid[cluster * 2] + count < next)
+						lightIndices[lightGrid[cluster * 2] + count++] = light.light;
+				}
+	}
+
+	// Upload, orphaning last frame's storage
+	ClusterBlock block = {};
+	block.gridSize = glm::uvec4(tilesX, tilesY, slices, 0);
+	block.tileSize = glm::vec4(static_cast<float>(screenWidth) / tilesX, static_cast<float>(screenHeight) / tilesY, 0.f, 0.f);
+	block.sliceParams = glm::vec4(sliceScale, sliceBias, nearPlane, farPlane);
+	clusterBuffer.update(&block, sizeof(block));
+
+	glBindBuffer(GL_TEXTURE_BUFFER, gridBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, lightGrid.size() * sizeof(unsigned int), lightGrid.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, indexBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, lightIndices.size() * sizeof(unsigned int), lightIndices.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+// Bind the froxel light lists to their texture units
+void LightClusters::bind() const
+{
+	glActiveTexture(GL_TEXTURE0 + LIGHT_GRID_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_BUFFER, gridTexture);
+	glActiveTexture(GL_TEXTURE0 + LIGHT_INDEX_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+	glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "lighting.h"
+#include "uniform_buffers.h"
+
+// Texture units the cluster light lists are bound to. Material textures use the units from 0 up.
+const unsigned int LIGHT_GRID_TEXTURE_UNIT = 14;
+const unsigned int LIGHT_INDEX_TEXTURE_UNIT = 15;
+
+/*
+	Clustered forward lighting. The view frustum is split into a grid of froxels: screen tiles in x/y
+	and exponentially spaced slices in view depth. Every frame each visible point light is binned on the CPU
+	into the froxels its sphere of influence touches, and the fragment shader only loops over the
+	lights of the froxel it falls into instead of over every light in the scene.
+
+	The per froxel lists are uploaded as two texture buffers:
+		lightGrid     (RG32UI) per froxel: offset into lightIndices, number of lights
+		lightIndices  (R32UI)  indices into the point lights of LightManager
+	The grid dimensions and depth slicing parameters go into the Clusters uniform block.
+*/
+class LightClusters
+{
+public:
+	// Constructor
+	LightClusters(unsigned int tilesX = 16, unsigned int tilesY = 16, unsigned int slices = 24);
+
+	// Methods
+	void update(const glm::mat4& view, float fovY, float aspect, float nearPlane, float farPlane, int screenWidth, int screenHeight,
+		const std::vector<PointLight>& pointLights, const std::vector<unsigned int>& visibleLights);
+	void bind() const;
+	size_t getLightIndexCount() const { return lightIndices.size(); }
+
+private:
+	// Froxel range touched by one light
+	struct LightBounds {
+		unsigned int light;
+		unsigned int minX, maxX, minY, maxY, minZ, maxZ;
+	};
+
+	unsigned int tilesX, tilesY, slices;
+	std::vector<LightBounds> bounds;
+	std::vector<unsigned int> lightGrid;
+	std::vector<unsigned int> lightIndices;
+
+	UniformBuffer clusterBuffer;
+	unsigned int gridBuffer, gridTexture;
+	unsigned int indexBuffer, indexTexture;
+};
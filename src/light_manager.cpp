@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <cstddef>
+#include "light_manager.h"
+
+// Lights the buffer has room for before it first has to grow
+const size_t INITIAL_LIGHT_CAPACITY = 16;
+
+static_assert(sizeof(PointLightData) == 64 && offsetof(PointLightData, specular) == 48, "PointLightData must match the layout of PointLight in frag.glsl");
+
+// Buffer target the point lights live in. A glad generated for a version below 4.3 has no storage
+// buffers at all, and then always uses the texture buffer.
+static GLenum pointLightTarget(bool useStorageBuffer)
+{
+#ifdef GL_VERSION_4_3
+	if (useStorageBuffer)
+		return GL_SHADER_STORAGE_BUFFER;
+#endif
+	return GL_TEXTURE_BUFFER;
+}
+
+LightManager::LightManager(const DirLight& dirLight)
+	: dirLight(dirLight), lightBuffer(LIGHT_BLOCK_BINDING, sizeof(LightBlock))
+{
+	// Shader storage buffers are core since 4.3, below that the lights are read through a texture buffer
+#ifdef GL_VERSION_4_3
+	useStorageBuffer = GLAD_GL_VERSION_4_3;
+#endif
+	GLenum target = pointLightTarget(useStorageBuffer);
+
+	capacity = INITIAL_LIGHT_CAPACITY;
+	glGenBuffers(1, &pointLightBuffer);
+	glBindBuffer(target, pointLightBuffer);
+	glBufferData(target, capacity * sizeof(PointLightData), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(target, 0);
+
+	if (!useStorageBuffer)
+	{
+		glGenTextures(1, &pointLightTexture);
+		glBindTexture(GL_TEXTURE_BUFFER, pointLightTexture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, pointLightBuffer);
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+	}
+}
+
+std::string LightManager::getShaderDefines() const
+{
+	return useStorageBuffer ? "#define POINT_LIGHT_STORAGE_BUFFER 1\n" : "";
+}
+
+// Storage blocks need GLSL 4.30, the texture buffer path runs on the shaders' own version
+const char* LightManager::getShaderVersion() const
+{
+	return useStorageBuffer ? "#version 430 core" : nullptr;
+}
+
+void LightManager::setupShader(Shader& shader) const
+{
+	if (useStorageBuffer)
+	{
+		shader.bindStorageBlock("PointLights", POINT_LIGHT_STORAGE_BINDING);
+	}
+	else
+	{
+		shader.use();
+		shader.setInt("pointLightData", POINT_LIGHT_TEXTURE_UNIT);
+	}
+}
+
+// Returns the index of the new light
+unsigned int LightManager::addPointLight(const PointLight& light)
+{
+	pointLights.push_back(light);
+	dirty.push_back(false);
+	markDirty(static_cast<unsigned int>(pointLights.size() - 1));
+	blockDirty = true;
+	return static_cast<unsigned int>(pointLights.size() - 1);
+}
+
+// The last light moves into the removed light's index
+void LightManager::removePointLight(unsigned int index)
+{
+	if (index >= pointLights.size())
+		return;
+
+	if (index != pointLights.size() - 1)
+	{
+		pointLights[index] = pointLights.back();
+		markDirty(index);
+	}
+	pointLights.pop_back();
+	dirty.pop_back();
+	blockDirty = true;
+}
+
+void LightManager::clearPointLights()
+{
+	pointLights.clear();
+	dirty.clear();
+	anyDirty = false;
+	blockDirty = true;
+}
+
+// Mutable access to a light, which is re-uploaded and gets its radius updated on the next upload()
+PointLight& LightManager::editPointLight(unsigned int index)
+{
+	markDirty(index);
+	return pointLights[index];
+}
+
+void LightManager::setDirLight(const DirLight& light)
+{
+	dirLight = light;
+	blockDirty = true;
+}
+
+// Keep the lights whose sphere of influence is in the frustum and overlaps any of the bounds
+void LightManager::cullPointLights(const Frustum& frustum, const std::vector<AABB>& visibleBounds)
+{
+	visibleLights.clear();
+	for (unsigned int i = 0; i < pointLights.size(); i++)
+	{
+		const PointLight& light = pointLights[i];
+		if (light.radius <= 0.f || !frustum.intersectsSphere(light.position, light.radius))
+			continue;
+
+		for (const AABB& bounds : visibleBounds)
+		{
+			if (bounds.intersectsSphere(light.position, light.radius))
+			{
+				visibleLights.push_back(i);
+				break;
+			}
+		}
+	}
+}
+
+// Send everything that changed since the last upload
+void LightManager::upload()
+{
+	if (blockDirty)
+	{
+		LightBlock block = makeLightBlock(dirLight, static_cast<unsigned int>(pointLights.size()));
+		lightBuffer.update(&block, sizeof(block));
+		blockDirty = false;
+	}
+	if (!anyDirty)
+		return;
+
+	// Edits may have changed a light's color or attenuation
+	for (size_t i = 0; i < pointLights.size(); i++)
+	{
+		if (dirty[i])
+			pointLights[i].updateRadius();
+	}
+
+	GLenum target = pointLightTarget(useStorageBuffer);
+	glBindBuffer(target, pointLightBuffer);
+
+	std::vector<PointLightData> data;
+	if (pointLights.size() > capacity)
+	{
+		// Grow geometrically and send every light with the new storage
+		while (capacity < pointLights.size())
+			capacity *= 2;
+		data.reserve(capacity);
+		for (const PointLight& light : pointLights)
+			data.push_back(packPointLight(light));
+		data.resize(capacity);
+		glBufferData(target, capacity * sizeof(PointLightData), data.data(), GL_DYNAMIC_DRAW);
+	}
+	else
+	{
+		// One upload per run of consecutive dirty lights
+		for (size_t begin = 0; begin < pointLights.size(); begin++)
+		{
+			if (!dirty[begin])
+				continue;
+			size_t end = begin;
+			data.clear();
+			while (end < pointLights.size() && dirty[end])
+				data.push_back(packPointLight(pointLights[end++]));
+			glBufferSubData(target, begin * sizeof(PointLightData), data.size() * sizeof(PointLightData), data.data());
+			begin = end;
+		}
+	}
+
+	glBindBuffer(target, 0);
+	std::fill(dirty.begin(), dirty.end(), false);
+	anyDirty = false;
+}
+
+void LightManager::bind() const
+{
+#ifdef GL_VERSION_4_3
+	if (useStorageBuffer)
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, POINT_LIGHT_STORAGE_BINDING, pointLightBuffer);
+		return;
+	}
+#endif
+
+	glActiveTexture(GL_TEXTURE0 + POINT_LIGHT_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_BUFFER, pointLightTexture);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void LightManager::markDirty(unsigned int index)
+{
+	dirty[index] = true;
+	anyDirty = true;
+}
+
+PointLightData LightManager::packPointLight(const PointLight& light)
+{
+	PointLightData data = {};
+	data.position = light.position;
+	data.ambient = light.ambient;
+	data.diffuse = light.diffuse;
+	data.specular = light.specular;
+	data.constant = light.constant;
+	data.linear = light.linear;
+	data.quadratic = light.quadratic;
+	data.radius = light.radius;
+	return data;
+}
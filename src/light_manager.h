@@ -0,0 +1,89 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "shader.cpp"
+#include "bounds.h"
+#include "lighting.h"
+#include "uniform_buffers.h"
+
+// Where the point light records are bound. The texture unit is used on GL 3.3, the storage block
+// binding when shader storage buffers are available.
+const unsigned int POINT_LIGHT_TEXTURE_UNIT = 13;
+const unsigned int POINT_LIGHT_STORAGE_BINDING = 0;
+
+// One point light as stored in the light buffer. The layout is the same under std430 and as four
+// RGBA32F texels: attenuation terms and the influence radius fill the padding after each vec3.
+struct PointLightData {
+	glm::vec3 position;
+	float constant;
+	glm::vec3 ambient;
+	float linear;
+	glm::vec3 diffuse;
+	float quadratic;
+	glm::vec3 specular;
+	float radius;
+};
+
+/*
+	Owns the scene's lights and their GPU copies. Point lights live in a growable buffer that the
+	fragment shader reads as a shader storage buffer when GL 4.3 is available, or as a texture buffer
+	otherwise, so their number is only limited by memory and changes without recompiling shaders.
+	The directional light and the point light count go into the Lights uniform block.
+
+	Edits only mark the touched lights dirty. upload() then sends each run of dirty lights with one
+	glBufferSubData, and only reallocates (and re-sends everything) when the buffer has to grow.
+
+	Every frame cullPointLights() keeps only the lights whose sphere of influence is inside the view
+	frustum and touches at least one visible object, and only those are binned into light clusters.
+*/
+class LightManager
+{
+public:
+	// Constructor
+	LightManager(const DirLight& dirLight);
+
+	// Shader variant matching the light storage, to pass to the Shader constructor
+	std::string getShaderDefines() const;
+	const char* getShaderVersion() const;
+
+	// Point the program's light storage at this manager's buffer
+	void setupShader(Shader& shader) const;
+
+	// Lights
+	unsigned int addPointLight(const PointLight& light);
+	void removePointLight(unsigned int index);
+	void clearPointLights();
+	PointLight& editPointLight(unsigned int index);
+	const PointLight& getPointLight(unsigned int index) const { return pointLights[index]; }
+	const std::vector<PointLight>& getPointLights() const { return pointLights; }
+	size_t getPointLightCount() const { return pointLights.size(); }
+
+	void setDirLight(const DirLight& light);
+	const DirLight& getDirLight() const { return dirLight; }
+
+	// Visibility
+	void cullPointLights(const Frustum& frustum, const std::vector<AABB>& visibleBounds);
+	const std::vector<unsigned int>& getVisibleLights() const { return visibleLights; }
+
+	// GPU
+	void upload();
+	void bind() const;
+	bool usesStorageBuffer() const { return useStorageBuffer; }
+
+private:
+	DirLight dirLight;
+	std::vector<PointLight> pointLights;
+	std::vector<bool> dirty;
+	std::vector<unsigned int> visibleLights;
+	bool anyDirty = false;
+	bool blockDirty = true;
+
+	bool useStorageBuffer = false;
+	UniformBuffer lightBuffer;
+	unsigned int pointLightBuffer, pointLightTexture = 0;
+	size_t capacity = 0;
+
+	void markDirty(unsigned int index);
+	static PointLightData packPointLight(const PointLight& light);
+};
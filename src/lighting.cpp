@@ -1,33 +1,62 @@
+#include <algorithm>
+#include <cmath>
 #include <glm/glm.hpp>
 #include "lighting.h"
 
+// Attenuated intensity below which a point light is treated as not reaching a point
+const float LIGHT_CUTOFF = 5.f / 256.f;
+
 // Direcitonal Light
 DirLight::DirLight(const glm::vec3 direction, const glm::vec3 ambient, const glm::vec3 diffuse, const glm::vec3 specular, float shininess)
 	: direction(direction), ambient(ambient), diffuse(diffuse), specular(specular), shininess(shininess)
 {
 }
 
-void DirLight::use(Shader& shader)
-{
-	shader.setVec3("dirLight.direction", direction);
-	shader.setVec3("dirLight.ambient", ambient);
-	shader.setVec3("dirLight.diffuse", diffuse);
-	shader.setVec3("dirLight.specular", specular);
-	shader.setFloat("material.shininess", shininess);
-}
-
 // Point Light
 PointLight::PointLight()
 	: position(glm::vec3(0)), ambient(glm::vec3(0)), diffuse(glm::vec3(0)), specular(glm::vec3(0)), shininess(0.f)
 {
+	updateRadius();
 }
 
 PointLight::PointLight(glm::vec3 position, float ambient, float diffuse, float specular, float shininess)
 	: position(position), ambient(glm::vec3(ambient)), diffuse(glm::vec3(diffuse)), specular(glm::vec3(specular)), shininess(shininess)
 {
+	updateRadius();
 }
 
 PointLight::PointLight(const glm::vec3& position, const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular, float shininess)
 	: position(position), ambient(ambient), diffuse(diffuse), specular(specular), shininess(shininess)
 {
+	updateRadius();
+}
+
+// Distance at which the light's brightest channel has attenuated below LIGHT_CUTOFF
+void PointLight::updateRadius()
+{
+	float intensity = std::max({ ambient.x, ambient.y, ambient.z, diffuse.x, diffuse.y, diffuse.z, specular.x, specular.y, specular.z });
+	float target = intensity / LIGHT_CUTOFF;
+	if (target <= constant)
+	{
+		radius = 0.f;
+		return;
+	}
+
+	// Solve quadratic * d^2 + linear * d + constant = target for d
+	if (quadratic <= 0.f)
+	{
+		radius = linear > 0.f ? (target - constant) / linear : INFINITY;
+		return;
+	}
+	float discriminant = linear * linear - 4.f * quadratic * (constant - target);
+	radius = (-linear + std::sqrt(discriminant)) / (2.f * quadratic);
+}
+
+// Pick attenuation terms that fade the light out over roughly range units
+void PointLight::setAttenuationRange(float range)
+{
+	constant = 1.f;
+	linear = 4.5f / range;
+	quadratic = 75.f / (range * range);
+	updateRadius();
 }
\ No newline at end of file
@@ -14,9 +14,6 @@ struct DirLight
 
 	// Constructor
 	DirLight(const glm::vec3 direction, const glm::vec3 ambient, const glm::vec3 diffuse, const glm::vec3 specular, float shininess);
-
-	// Methods
-	void use(Shader& shader);
 };
 
 struct PointLight
@@ -28,11 +25,21 @@ struct PointLight
 	glm::vec3 specular;
 	float shininess;
 
+	// Attenuation
+	float constant = 1.f;
+	float linear = .09f;
+	float quadratic = .032f;
+
+	// Distance past which the light adds nothing visible, derived from color and attenuation.
+	// Call updateRadius() after changing either.
+	float radius = 0.f;
+
 	// Constructor
 	PointLight();
 	PointLight(glm::vec3 position, float ambient, float diffuse, float specular, float shininess);
 	PointLight(const glm::vec3& position, const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular, float shininess);
 
 	// Methods
-	void use(Shader& shader);
+	void updateRadius();
+	void setAttenuationRange(float range);
 };
\ No newline at end of file
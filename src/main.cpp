@@ -1,3 +1,7 @@
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
 #include <iostream>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -5,21 +9,33 @@
 #include "camera.h"
 #include "stb_image.h"
 #include "model.h"
-#include "lighting.h"
+#include "texture_loader.h"
+#include "scene.h"
+#include "camera_path.h"
+#include "offscreen_target.h"
+#include "profiler.h"
 
 #ifdef PROJECT_ROOT_DIR
-#define NR_POINT_LIGHTS 10
 
 // Constants
 const unsigned int SCREEN_WIDTH = 1080;
 const unsigned int SCREEN_HEIGHT = 1080;
-const std::string VERTEX_SHADER_PATH = std::string(PROJECT_ROOT_DIR) + "/assets/vert.glsl";
-const std::string FRAGMENT_SHADER_PATH = std::string(PROJECT_ROOT_DIR) + "/assets/frag.glsl";
 const std::string MODEL_ASSET_PATH = std::string(PROJECT_ROOT_DIR) + "/assets/backpack.obj";
+const float HEADLESS_TIME_STEP = 1.f / 60.f;	// Simulated frame time of headless runs, so they render the same frames every time
+const VertexFormat VERTEX_FORMAT = VertexFormat::Float;	// VertexFormat::Quantized halves vertex memory and bandwidth
+const unsigned int DEFAULT_LIGHT_COUNT = 10;	// Point lights scattered around the model, --lights overrides it
 
 // Delta time
 float deltaTime = 0.f;
 float lastFrame = 0.f;
+float lastStatsUpdate = 0.f;
+
+// Picking
+bool pickWasPressed = false;
+
+// Occlusion culling, toggled with O
+bool occlusionCulling = false;
+bool occlusionWasPressed = false;
 
 // Camera
 Camera camera = Camera(glm::vec3(0.f, 0.f, 3.f), glm::vec3(0.f, 0.f, -1.f), glm::vec3(0.f, 1.f, 0.f));
@@ -27,7 +43,25 @@ bool firstMouse = true;
 float lastX = SCREEN_WIDTH / 2.f;
 float lastY = SCREEN_HEIGHT / 2.f;
 
-int main();
+// Command line options
+struct RunOptions {
+	std::string modelPath = MODEL_ASSET_PATH;
+	std::string cameraPath;
+	unsigned int frameCount = 0;	// 0 runs until the window is closed
+	int width = SCREEN_WIDTH;
+	int height = SCREEN_HEIGHT;
+	bool headless = false;
+	std::string dumpDirectory;		// Where headless frames are written, none if empty
+	unsigned int lightSeed = static_cast<unsigned int>(time(0));
+	unsigned int lightCount = DEFAULT_LIGHT_COUNT;
+	std::string profilePath;		// Chrome trace written on exit, profiling is off if empty
+	bool occlusionCulling = false;
+	int expectedOccluded = -1;		// Meshes every headless frame after the first must report occluded, unchecked if negative
+	int expectedDrawn = -1;			// Meshes every headless frame after the first must draw, unchecked if negative
+};
+
+int main(int argc, char** argv);
+bool parseArguments(int argc, char** argv, RunOptions& options);
 
 // Callback functions
 void framebufferSizeCallback(GLFWwindow *window, int width, int height);
@@ -38,8 +72,16 @@ void processInput(GLFWwindow* window);
 // TODO:
 //		- Move onto 'Advanced OpenGL' > 'Depth Testing'
 
-int main()
+int main(int argc, char** argv)
 {
+	RunOptions options;
+	if (!parseArguments(argc, argv, options))
+		return EXIT_FAILURE;
+
+	CameraPath cameraPath;
+	if (!options.cameraPath.empty() && !cameraPath.load(options.cameraPath))
+		return EXIT_FAILURE;
+
 	// Initialize glfw
 	if (!glfwInit())
 	{
@@ -50,8 +92,11 @@ int main()
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-	// Create window
-	GLFWwindow* window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Model Loader", NULL, NULL);
+	// Create window. Headless runs still need one for the context, but never show it and render
+	// into an offscreen framebuffer instead.
+	if (options.headless)
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(options.width, options.height, "Model Loader", NULL, NULL);
 	if (window == NULL)
 	{
 		std::cout << "Failed to create glfw window.\n";
@@ -75,93 +120,223 @@ int main()
 	// Settings
 	stbi_set_flip_vertically_on_load(true);
 	glEnable(GL_DEPTH_TEST);
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	if (!options.headless)
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
-	// Shader program
-	Shader shader(VERTEX_SHADER_PATH.c_str(), FRAGMENT_SHADER_PATH.c_str());
-
-	// 3D model
-	Model model(MODEL_ASSET_PATH.c_str());
-
-	// Lighting
-	DirLight dirLight(glm::vec3(2.f, -2.f, -1.f), glm::vec3(.2f), glm::vec3(1.f), glm::vec3(1.f), 16);
-	std::vector<PointLight> pointLights(NR_POINT_LIGHTS);
-	srand(time(0));
-	for (unsigned int i = 0; i < NR_POINT_LIGHTS; i++)
+	std::unique_ptr<OffscreenTarget> offscreenTarget;
+	if (options.headless)
 	{
-		// Construct point light
-		float randXPos = (rand() % 21 - 10.0) + .0f;
-		float randYPos = (rand() % 21 - 10.0) + .0f;
-		float randZPos = (rand() % 21 - 10.0) + .0f;
-		pointLights[i] = PointLight(glm::vec3(randXPos, randYPos, randZPos), 0.05f, 1.f, 1.f, 16);
-
-		// Assign ambient
-		pointLights[i].ambient = glm::vec3(0.05f);
-		
-		// Diffuse
-		float randR = rand() % 10 + .05f;
-		float randG = rand() % 10 + .05f;
-		float randB = rand() % 10 + .05f;
-		pointLights[i].diffuse = glm::vec3(randR, randG, randB);
-
-		// Specular
-		pointLights[i].specular = glm::vec3((rand() % 10 + 1) * 0.1f);
+		offscreenTarget = std::make_unique<OffscreenTarget>(options.width, options.height);
+		if (!offscreenTarget->isComplete())
+			return EXIT_FAILURE;
+		if (!options.dumpDirectory.empty())
+			std::filesystem::create_directories(options.dumpDirectory);
 	}
 
-	while (!glfwWindowShouldClose(window))
+	// Scope timings are only recorded when asked for
+	Profiler& profiler = Profiler::shared();
+	profiler.setEnabled(!options.profilePath.empty());
+
+	// Model and lights. Lights are random, from a fixed seed if one was given.
+	Scene scene(options.modelPath, VERTEX_FORMAT, options.lightCount, options.lightSeed);
+	Model& model = scene.getModel();
+	LightManager& lights = scene.getLights();
+
+	// Headless runs wait for the query results, so they cull the same meshes on every run
+	occlusionCulling = options.occlusionCulling;
+	if (occlusionCulling)
+		model.setOcclusionCulling(true, options.headless);
+	bool checksPassed = true;
+
+	// Headless frames must not depend on how fast textures decode
+	if (options.headless)
+		TextureLoader::shared().finishUploads();
+
+	for (unsigned int frame = 0; !glfwWindowShouldClose(window) && (options.frameCount == 0 || frame < options.frameCount); frame++)
 	{
-		// Calculate delta
-		float currentFrame = static_cast<float>(glfwGetTime());
+		profiler.beginFrame();
+		PROFILE_SCOPE("frame");
+
+		// Calculate delta. Headless runs step time by a fixed amount per frame.
+		float currentFrame = options.headless ? frame * HEADLESS_TIME_STEP : static_cast<float>(glfwGetTime());
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
-		// Poll key input
-		processInput(window);
+		// Poll key input, or follow the camera path
+		if (!options.headless)
+			processInput(window);
+		if (!cameraPath.empty())
+			cameraPath.apply(currentFrame, camera);
 
-		glClearColor(0.15f, 0.15f, 0.15f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		// Swap in textures that finished decoding since last frame
+		{
+			PROFILE_SCOPE("texture uploads");
+			TextureLoader::shared().processUploads();
+		}
+		if (offscreenTarget)
+			offscreenTarget->bind();
 
-		// Activate shader program
-		shader.use();
+		int framebufferWidth = options.width, framebufferHeight = options.height;
+		if (!offscreenTarget)
+			glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+		scene.render(camera, framebufferWidth, framebufferHeight);
 
-		// Camera transformations
-		glm::mat4 viewMtrx = camera.getViewMatrix();
-		glm::mat4 projectionMtrx = glm::perspective(glm::radians(camera.fov), static_cast<float>(SCREEN_WIDTH) / SCREEN_HEIGHT, .1f, 100.f);
-		shader.setMat4("projection", projectionMtrx);
-		shader.setMat4("view", viewMtrx);
-		shader.setVec3("viewPos", camera.position);
+		// Write the frame out
+		if (offscreenTarget && !options.dumpDirectory.empty())
+		{
+			char filename[32];
+			std::snprintf(filename, sizeof(filename), "frame_%05u.ppm", frame);
+			offscreenTarget->writePPM((std::filesystem::path(options.dumpDirectory) / filename).string());
+		}
 
-		// Model transformations
-		glm::mat4 modelMtrx(1.f);
-		shader.setMat4("model", modelMtrx);
-		glm::mat3 normalMtrx = glm::transpose(glm::inverse(glm::mat3(modelMtrx)));
-		shader.setMat3("normalModel", normalMtrx);
+		// Headless runs have no input or window to report to. Occlusion results of a frame are used by
+		// the next one, so the first frame draws everything.
+		if (options.headless)
+		{
+			const CullStats& stats = model.getCullStats();
+			if (options.expectedOccluded >= 0 && frame > 0 && stats.occludedMeshes != static_cast<unsigned int>(options.expectedOccluded))
+			{
+				std::cout << "ERROR::MAIN::Frame " << frame << " has " << stats.occludedMeshes << " occluded meshes, expected " << options.expectedOccluded << std::endl;
+				checksPassed = false;
+			}
+			if (options.expectedDrawn >= 0 && frame > 0 && stats.drawnMeshes != static_cast<unsigned int>(options.expectedDrawn))
+			{
+				std::cout << "ERROR::MAIN::Frame " << frame << " has " << stats.drawnMeshes << " drawn meshes, expected " << options.expectedDrawn << std::endl;
+				checksPassed = false;
+			}
+
+			// A frame that draws nothing occludes nothing either, it must not pass for one that culled
+			if (options.expectedOccluded >= 0 && stats.drawnMeshes == 0)
+			{
+				std::cout << "ERROR::MAIN::Frame " << frame << " draws no meshes" << std::endl;
+				checksPassed = false;
+			}
+			glFinish();
+			continue;
+		}
 
-		// Directional and point lighting
-		dirLight.use(shader);
+		// Pick the mesh under the crosshair on click
+		bool pickPressed = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+		if (pickPressed && !pickWasPressed)
+		{
+			unsigned int pickedMesh;
+			float pickedDistance;
+			if (model.pick(camera.position, camera.getFront(), scene.getModelMatrix(), pickedMesh, pickedDistance))
+				std::cout << "Picked mesh " << pickedMesh << " of node '" << model.getNodes()[model.getMeshNode(pickedMesh)].name << "' at distance " << pickedDistance << "\n";
+		}
+		pickWasPressed = pickPressed;
 
-		for (unsigned int i = 0; i < NR_POINT_LIGHTS; i++)
+		// Toggle occlusion culling
+		bool occlusionPressed = glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS;
+		if (occlusionPressed && !occlusionWasPressed)
 		{
-			shader.setVec3("pointLights[" + std::to_string(i) + "].position", pointLights[i].position);
-			shader.setVec3("pointLights[" + std::to_string(i) + "].ambient", pointLights[i].ambient);
-			shader.setVec3("pointLights[" + std::to_string(i) + "].diffuse", pointLights[i].diffuse);
-			shader.setVec3("pointLights[" + std::to_string(i) + "].specular", pointLights[i].specular);
-
-			// NOTE: Keep these three the same for now
-			shader.setFloat("pointLights[" + std::to_string(i) + "].constant", 1.f);	
-			shader.setFloat("pointLights[" + std::to_string(i) + "].linear", .09f);
-			shader.setFloat("pointLights[" + std::to_string(i) + "].quadratic", .032f);
+			occlusionCulling = !occlusionCulling;
+			model.setOcclusionCulling(occlusionCulling);
 		}
+		occlusionWasPressed = occlusionPressed;
 
-		// Draw model
-		model.draw(shader);
+		// Report culling results a few times per second
+		if (currentFrame - lastStatsUpdate > .5f)
+		{
+			const CullStats& stats = model.getCullStats();
+			std::string title = "Model Loader - " + std::to_string(stats.drawnMeshes) + " meshes (" + std::to_string(stats.drawnTriangles)
+				+ " triangles) drawn, " + std::to_string(stats.culledMeshes)
+				+ " culled, " + std::to_string(stats.occludedMeshes) + " occluded, " + std::to_string(lights.getVisibleLights().size()) + "/"
+				+ std::to_string(lights.getPointLightCount()) + " lights";
+			glfwSetWindowTitle(window, title.c_str());
+			lastStatsUpdate = currentFrame;
+		}
 
-		glfwSwapBuffers(window);
+		{
+			PROFILE_SCOPE("swap");
+			glfwSwapBuffers(window);
+		}
 		glfwPollEvents();
 	}
 
+	// Read back the last frames while the context is still alive
+	if (profiler.isEnabled())
+	{
+		profiler.release();
+		profiler.printStats();
+		profiler.writeChromeTrace(options.profilePath);
+	}
+
 	glfwTerminate();
-	return 0;
+	return checksPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Parse the command line:
+//
+//		model_loader_main [--model <file>] [--camera-path <file>] [--frames <count>] [--size <width>x<height>]
+//		                  [--seed <light seed>] [--lights <count>] [--headless] [--dump-frames <directory>]
+//		                  [--profile <trace.json>] [--occlusion] [--expect-occluded <meshes>] [--expect-drawn <meshes>]
+//
+// Headless runs render offscreen and need a frame count, so they end on their own. With
+// --expect-occluded or --expect-drawn they fail unless every frame after the first reports that many
+// meshes occluded or drawn. Checking occlusion also fails any frame that draws no meshes at all.
+bool parseArguments(int argc, char** argv, RunOptions& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (argument == "--headless")
+			options.headless = true;
+		else if (argument == "--occlusion")
+			options.occlusionCulling = true;
+		else if (argument == "--expect-occluded" && hasValue)
+			options.expectedOccluded = static_cast<int>(std::strtol(argv[++i], nullptr, 10));
+		else if (argument == "--expect-drawn" && hasValue)
+			options.expectedDrawn = static_cast<int>(std::strtol(argv[++i], nullptr, 10));
+		else if (argument == "--model" && hasValue)
+			options.modelPath = argv[++i];
+		else if (argument == "--camera-path" && hasValue)
+			options.cameraPath = argv[++i];
+		else if (argument == "--dump-frames" && hasValue)
+			options.dumpDirectory = argv[++i];
+		else if (argument == "--profile" && hasValue)
+			options.profilePath = argv[++i];
+		else if (argument == "--seed" && hasValue)
+			options.lightSeed = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+		else if (argument == "--lights" && hasValue)
+			options.lightCount = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+		else if (argument == "--frames" && hasValue)
+			options.frameCount = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+		else if (argument == "--size" && hasValue && std::sscanf(argv[i + 1], "%dx%d", &options.width, &options.height) == 2
+			&& options.width > 0 && options.height > 0)
+			i++;
+		else
+		{
+			std::cout << "Usage: model_loader_main [--model <file>] [--camera-path <file>] [--frames <count>] [--size <width>x<height>]\n"
+				<< "                         [--seed <light seed>] [--lights <count>] [--headless] [--dump-frames <directory>]\n"
+				<< "                         [--profile <trace.json>] [--occlusion] [--expect-occluded <meshes>] [--expect-drawn <meshes>]\n";
+			return false;
+		}
+	}
+
+	if (options.headless && options.frameCount == 0)
+	{
+		std::cout << "ERROR::MAIN::--headless needs --frames" << std::endl;
+		return false;
+	}
+	if (!options.dumpDirectory.empty() && !options.headless)
+	{
+		std::cout << "ERROR::MAIN::--dump-frames needs --headless" << std::endl;
+		return false;
+	}
+	if (options.expectedOccluded >= 0 && (!options.headless || !options.occlusionCulling))
+	{
+		std::cout << "ERROR::MAIN::--expect-occluded needs --headless and --occlusion" << std::endl;
+		return false;
+	}
+	if (options.expectedDrawn >= 0 && !options.headless)
+	{
+		std::cout << "ERROR::MAIN::--expect-drawn needs --headless" << std::endl;
+		return false;
+	}
+	return true;
 }
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height)
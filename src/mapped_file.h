@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. Pages are only faulted in when touched and are
+// released again by close(), so large files never need a second copy in CPU memory.
+class MappedFile
+{
+public:
+	// Constructor
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	// Methods
+	bool open(const std::string& path);
+	void close();
+	bool isOpen() const { return mapped != nullptr; }
+	const char* data() const { return mapped; }
+	size_t size() const { return length; }
+
+private:
+	const char* mapped = nullptr;
+	size_t length = 0;
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+};
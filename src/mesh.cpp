@@ -0,0 +1,44 @@
+#include "mesh.h"
+#include "shader.cpp"
+#include <GLFW/glfw3.h>
+
+Mesh::Mesh(unsigned int baseVertex, unsigned int firstIndex, unsigned int indexCount, std::vector<Texture> textures)
+	: textures(textures), baseVertex(baseVertex), firstIndex(firstIndex), indexCount(indexCount)
+{
+	lods[0] = MeshLod{ firstIndex, indexCount, 0.f };
+
+	unsigned int diffuseNr = 1;
+	unsigned int specularNr = 1;
+
+	// Count number of diffuse and specular textures respectfully
+	for (const Texture& texture : textures)
+	{
+		std::string number;
+		if (texture.type == "texture_diffuse")
+			number = std::to_string(diffuseNr++);
+		else if (texture.type == "texture_specular")
+			number = std::to_string(specularNr++);
+		samplerNames.push_back("material." + texture.type + number);
+	}
+}
+
+void Mesh::bindTextures(Shader& shader)
+{
+	// Sampler locations are looked up once per program, not per frame
+	if (samplerProgram != shader.ID)
+	{
+		samplerLocs.clear();
+		for (const std::string& name : samplerNames)
+			samplerLocs.push_back(shader.getUniformLocation(name));
+		samplerProgram = shader.ID;
+	}
+
+	for (unsigned int i = 0; i < textures.size(); i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + i);
+
+		// Set sampler to correct texture unit
+		shader.setInt(samplerLocs[i], i);
+		glBindTexture(GL_TEXTURE_2D, textures[i].id);
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include "mesh_data.h"
+
+class Shader;
+
+struct Texture {
+	unsigned int id;
+	std::string type;
+	std::string path;
+};
+
+// Index range of one level of detail in its Model's shared index buffer
+struct MeshLod {
+	unsigned int firstIndex = 0;
+	unsigned int indexCount = 0;
+	float error = 0.f;
+};
+
+// A range of its Model's shared vertex and index buffers, plus the textures it is drawn with
+class Mesh
+{
+public:
+	// Properties
+	std::vector <Texture> textures;
+	unsigned int baseVertex;
+	unsigned int firstIndex;
+	unsigned int indexCount;
+	unsigned int indexType = GL_UNSIGNED_INT;	// Of the shared index buffer, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	unsigned int materialID = 0;	// Meshes with the same textures share an ID, assigned by Model
+	unsigned int node = 0;			// Scene graph node the mesh belongs to
+	MeshLod lods[MAX_MESH_LODS];	// lods[0] is the full resolution range above
+	unsigned int lodCount = 1;
+	AABB bounds;					// Object space
+	BoundingSphere sphere;
+	
+	// Constructor
+	Mesh(unsigned int baseVertex, unsigned int firstIndex, unsigned int indexCount, std::vector<Texture> textures);
+
+	// Methods
+	void bindTextures(Shader& shader);
+
+private:
+	// Sampler uniform of each texture, e.g. material.texture_diffuse1, named once by the constructor
+	std::vector<std::string> samplerNames;
+	std::vector<int> samplerLocs;	// Of samplerNames in samplerProgram, looked up on its first bind
+	unsigned int samplerProgram = 0;
+};
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "bounds.h"
+
+/*
+	Plain records of an imported model, as the CPU import stage produces them and the mesh cache and
+	packed models store them. Nothing here depends on GL, the Mesh class in mesh.h is what a Model
+	uploads them into.
+*/
+
+struct Vertex {
+	/*
+	Structs have a special property in C++ such that their members are consecutive in memory. If we
+	were to create a Vertex struct...
+
+		Vertex vertex;
+		vertex.Position  = glm::vec3(0.2f, 0.4f, 0.6f);
+		vertex.Normal    = glm::vec3(0.0f, 1.0f, 0.0f);
+		vertex.TexCoords = glm::vec2(1.0f, 0.0f);
+
+	then the memory layout of the members will be equivalent of this:
+
+		[0.2f, 0.4f, 0.6f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f];
+
+	And therefore, we can pass a pointer to even a LIST of Vertex structs as the buffer's data,
+	translating perfectly as an arguement for glBufferData:
+
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+
+	The best part? We can add another attribute to our Vertex, and our rendering code wont break (ie. we
+	dont'a have to retype the arguements!):
+
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));  
+	*/
+	glm::vec3 position;
+	glm::vec3 normal;
+	glm::vec2 texCoords;
+};
+
+// Texture reference as found in a material, before it has been loaded into GL
+struct TextureRef {
+	std::string type;
+	std::string path;
+};
+
+// Meshes with at most this many vertices can be drawn with 16-bit indices, which are relative to each mesh's first vertex
+const size_t MAX_SHORT_INDEX_VERTICES = 65536;
+
+// Levels of detail per mesh, including the full resolution one
+const unsigned int MAX_MESH_LODS = 4;
+
+// Simplified index list of a mesh, into the same vertices as the full resolution one
+struct LodData {
+	std::vector<unsigned int> indices;
+	float error = 0.f;	// Largest distance from the original surface, in model units
+};
+
+// Flattened mesh as produced by the importer (or read back from the mesh cache)
+struct MeshData {
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	std::vector<TextureRef> textures;	// Its material's, so each mesh can be uploaded and cached on its own
+	unsigned int material = 0;	// Into the materials of the import, packed models don't keep it
+	std::vector<LodData> lods;	// LOD 1 and coarser, at most MAX_MESH_LODS - 1
+	AABB bounds;
+	BoundingSphere sphere;
+};
+
+// Material of an imported scene, the texture references a mesh is drawn with
+struct MaterialData {
+	std::string name;
+	std::vector<TextureRef> textures;
+};
+
+// Node of the imported scene graph. Nodes are stored parents first and each one owns a contiguous
+// range of meshes, whose vertices are already transformed by its worldTransform.
+struct ModelNode {
+	std::string name;
+	int parent = -1;	// -1 for the root
+	glm::mat4 localTransform = glm::mat4(1.f);
+	glm::mat4 worldTransform = glm::mat4(1.f);
+	unsigned int firstMesh = 0;
+	unsigned int meshCount = 0;
+};
@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <cmath>
+#include "mesh_optimizer.h"
+
+// Cache modelled by the Forsyth scoring. Bigger than the one the metrics assume, which still orders
+// triangles well for smaller caches.
+const int FORSYTH_CACHE_SIZE = 32;
+const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+const float FORSYTH_LAST_TRIANGLE_SCORE = .75f;
+const float FORSYTH_VALENCE_BOOST_SCALE = 2.f;
+const float FORSYTH_VALENCE_BOOST_POWER = .5f;
+
+// Vertex shader invocations of a triangle list on a FIFO cache of cacheSize entries
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize)
+{
+	VertexCacheStats stats;
+	stats.triangleCount = indices.size() / 3;
+	stats.vertexCount = vertexCount;
+
+	// A vertex is in the cache if it was pushed within the last cacheSize misses
+	std::vector<size_t> pushedAt(vertexCount, 0);
+	for (unsigned int index : indices)
+	{
+		if (pushedAt[index] == 0 || stats.transformedVertices - (pushedAt[index] - 1) >= cacheSize)
+		{
+			stats.transformedVertices++;
+			pushedAt[index] = stats.transformedVertices;
+		}
+	}
+	return stats;
+}
+
+// Forsyth's score of a vertex at cachePosition (-1 if not cached) that is still used by liveTriangles
+// triangles. Recently used vertices score high, and so do vertices with few triangles left, so
+// that the lone triangles don't get stranded.
+static float vertexScore(int cachePosition, unsigned int liveTriangles)
+{
+	if (liveTriangles == 0)
+		return -1.f;
+
+	float score = 0.f;
+	if (cachePosition >= 0)
+	{
+		// The vertices of the last triangle get a fixed score, so the next one doesn't simply reuse its edge
+		if (cachePosition < 3)
+			score = FORSYTH_LAST_TRIANGLE_SCORE;
+		else
+			score = std::pow(1.f - float(cachePosition - 3) / (FORSYTH_CACHE_SIZE - 3), FORSYTH_CACHE_DECAY_POWER);
+	}
+	return score + FORSYTH_VALENCE_BOOST_SCALE * std::pow(float(liveTriangles), -FORSYTH_VALENCE_BOOST_POWER);
+}
+
+// Reorder triangles greedily, always emitting the best scoring triangle around the simulated LRU cache
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount)
+{
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+		return;
+
+	// Triangles of every vertex. The live ones are kept at the front of each range.
+	std::vector<unsigned int> triangleOffsets(vertexCount + 1, 0);
+	for (unsigned int index : indices)
+		triangleOffsets[index + 1]++;
+	for (size_t i = 1; i <= vertexCount; i++)
+		triangleOffsets[i] += triangleOffsets[i - 1];
+	std::vector<unsigned int> vertexTriangles(indices.size());
+	std::vector<unsigned int> liveTriangles(vertexCount, 0);
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		unsigned int vertex = indices[i];
+		vertexTriangles[triangleOffsets[vertex] + liveTriangles[vertex]++] = static_cast<unsigned int>(i / 3);
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> scores(vertexCount);
+	for (size_t i = 0; i < vertexCount; i++)
+		scores[i] = vertexScore(-1, liveTriangles[i]);
+
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<unsigned char> emitted(triangleCount, 0);
+	unsigned int best = 0;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		triangleScores[t] = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+		if (triangleScores[t] > triangleScores[best])
+			best = static_cast<unsigned int>(t);
+	}
+
+	std::vector<unsigned int> result;
+	result.reserve(indices.size());
+	std::vector<unsigned int> cache, nextCache;
+	cache.reserve(FORSYTH_CACHE_SIZE + 3);
+	nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+	size_t scanCursor = 0;
+
+	while (result.size() < indices.size())
+	{
+		// Emit the triangle and take it out of its vertices' live lists
+		emitted[best] = 1;
+		const unsigned int* triangle = &indices[best * 3];
+		for (int corner = 0; corner < 3; corner++)
+		{
+			unsigned int vertex = triangle[corner];
+			result.push_back(vertex);
+
+			unsigned int* begin = &vertexTriangles[triangleOffsets[vertex]];
+			unsigned int* end = begin + liveTriangles[vertex];
+			std::swap(*std::find(begin, end, best), *(end - 1));
+			liveTriangles[vertex]--;
+		}
+
+		// Its vertices move to the front of the cache, the oldest ones fall off the back
+		nextCache.assign(triangle, triangle + 3);
+		for (unsigned int vertex : cache)
+		{
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+				nextCache.push_back(vertex);
+		}
+		for (size_t i = FORSYTH_CACHE_SIZE; i < nextCache.size(); i++)
+		{
+			cachePosition[nextCache[i]] = -1;
+			scores[nextCache[i]] = vertexScore(-1, liveTriangles[nextCache[i]]);
+		}
+		if (nextCache.size() > size_t(FORSYTH_CACHE_SIZE))
+			nextCache.resize(FORSYTH_CACHE_SIZE);
+		std::swap(cache, nextCache);
+
+		for (size_t i = 0; i < cache.size(); i++)
+		{
+			cachePosition[cache[i]] = static_cast<int>(i);
+			scores[cache[i]] = vertexScore(static_cast<int>(i), liveTriangles[cache[i]]);
+		}
+
+		// Only triangles around the cache changed score, so the next one is searched among them
+		float bestScore = -1.f;
+		for (unsigned int vertex : cache)
+		{
+			for (unsigned int i = 0; i < liveTriangles[vertex]; i++)
+			{
+				unsigned int t = vertexTriangles[triangleOffsets[vertex] + i];
+				triangleScores[t] = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+				if (triangleScores[t] > bestScore)
+				{
+					bestScore = triangleScores[t];
+					best = t;
+				}
+			}
+		}
+
+		// Nothing left around the cache, continue with the next triangle not yet emitted
+		if (bestScore < 0.f && result.size() < indices.size())
+		{
+			while (emitted[scanCursor])
+				scanCursor++;
+			best = static_cast<unsigned int>(scanCursor);
+		}
+	}
+
+	indices.swap(result);
+}
+
+// Sort runs of triangles so the ones facing away from the mesh center are drawn first. A run ends
+// wherever the FIFO cache misses on all three vertices of a triangle, where the cache is cold
+// anyway, so reordering them costs almost nothing in cache efficiency (Sander et al. 2007).
+void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices)
+{
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount < 2)
+		return;
+
+	// Cluster boundaries
+	std::vector<size_t> clusterStarts;
+	std::vector<size_t> pushedAt(vertices.size(), 0);
+	size_t misses = 0;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		int triangleMisses = 0;
+		for (int corner = 0; corner < 3; corner++)
+		{
+			unsigned int index = indices[t * 3 + corner];
+			if (pushedAt[index] == 0 || misses - (pushedAt[index] - 1) >= VERTEX_CACHE_SIZE)
+			{
+				misses++;
+				pushedAt[index] = misses;
+				triangleMisses++;
+			}
+		}
+		if (t == 0 || triangleMisses == 3)
+			clusterStarts.push_back(t);
+	}
+	if (clusterStarts.size() < 2)
+		return;
+	clusterStarts.push_back(triangleCount);
+
+	// Area weighted centroid of the mesh
+	glm::vec3 meshCenter(0.f);
+	float meshArea = 0.f;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		const glm::vec3& p0 = vertices[indices[t * 3]].position;
+		const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+		const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+		float area = glm::length(glm::cross(p1 - p0, p2 - p0));
+		meshCenter += (p0 + p1 + p2) * (area / 3.f);
+		meshArea += area;
+	}
+	if (meshArea > 0.f)
+		meshCenter /= meshArea;
+
+	// How far each cluster faces away from the center
+	size_t clusterCount = clusterStarts.size() - 1;
+	std::vector<float> sortKeys(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		glm::vec3 center(0.f), normal(0.f);
+		float area = 0.f;
+		for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++)
+		{
+			const glm::vec3& p0 = vertices[indices[t * 3]].position;
+			const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+			const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+			glm::vec3 triangleNormal = glm::cross(p1 - p0, p2 - p0);
+			float triangleArea = glm::length(triangleNormal);
+			center += (p0 + p1 + p2) * (triangleArea / 3.f);
+			normal += triangleNormal;
+			area += triangleArea;
+		}
+		float normalLength = glm::length(normal);
+		sortKeys[c] = area > 0.f && normalLength > 0.f ? glm::dot(center / area - meshCenter, normal / normalLength) : 0.f;
+	}
+
+	std::vector<unsigned int> order(clusterCount);
+	for (unsigned int c = 0; c < clusterCount; c++)
+		order[c] = c;
+	std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<unsigned int> result;
+	result.reserve(indices.size());
+	for (unsigned int c : order)
+		result.insert(result.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+	indices.swap(result);
+}
+
+// Renumber vertices by first use. Vertices no triangle uses are dropped.
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	const unsigned int unused = ~0u;
+	std::vector<unsigned int> remap(vertices.size(), unused);
+	std::vector<Vertex> result;
+	result.reserve(vertices.size());
+
+	for (unsigned int& index : indices)
+	{
+		if (remap[index] == unused)
+		{
+			remap[index] = static_cast<unsigned int>(result.size());
+			result.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+	vertices.swap(result);
+}
+
+void optimizeMesh(MeshData& data)
+{
+	optimizeVertexCache(data.indices, data.vertices.size());
+	optimizeOverdraw(data.indices, data.vertices);
+	optimizeVertexFetch(data.vertices, data.indices);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+#include "mesh_data.h"
+
+/*
+	Import time reordering of a mesh's triangles and vertices for the GPU, without changing what is
+	drawn:
+
+		optimizeVertexCache    Forsyth's linear-speed vertex cache optimization, so consecutive
+		                       triangles reuse the vertices the post-transform cache still holds
+		optimizeOverdraw       splits the cache optimized order where the cache starts cold anyway
+		                       and draws the outward facing clusters first, so they occlude the rest
+		optimizeVertexFetch    renumbers vertices in the order the indices first use them, so vertex
+		                       fetch walks the buffer front to back
+
+	They are meant to run in that order. analyzeVertexCache measures the result against a FIFO cache
+	like the one on most hardware.
+*/
+
+// Post-transform cache entries of the hardware the metrics are measured for
+const unsigned int VERTEX_CACHE_SIZE = 16;
+
+// Vertex shader invocations of a triangle list on a simulated FIFO vertex cache
+struct VertexCacheStats {
+	size_t transformedVertices = 0;
+	size_t triangleCount = 0;
+	size_t vertexCount = 0;
+
+	// Average cache miss ratio, vertices transformed per triangle (0.5 at best for large grids, 3 at worst)
+	float acmr() const { return triangleCount ? float(transformedVertices) / triangleCount : 0.f; }
+	// Average transform to vertex ratio, vertices transformed per vertex (1 at best)
+	float atvr() const { return vertexCount ? float(transformedVertices) / vertexCount : 0.f; }
+
+	void add(const VertexCacheStats& other)
+	{
+		transformedVertices += other.transformedVertices;
+		triangleCount += other.triangleCount;
+		vertexCount += other.vertexCount;
+	}
+};
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize = VERTEX_CACHE_SIZE);
+
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount);
+void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices);
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+// All three passes, in order
+void optimizeMesh(MeshData& data);
@@ -0,0 +1,342 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+
+// Meshes with fewer triangles than this are cheap enough to always draw in full
+const size_t MIN_LOD_INDICES = 3 * 64;
+
+// Largest simplification error accepted for any level, relative to the mesh's bounding box diagonal
+const float MAX_LOD_ERROR = .1f;
+
+// A level has to drop at least this share of the previous level's triangles to be kept
+const float MIN_LOD_REDUCTION = .1f;
+
+// Symmetric 4x4 matrix summing the squared distances to a set of planes
+struct Quadric
+{
+	double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+	double a11 = 0, a12 = 0, a13 = 0;
+	double a22 = 0, a23 = 0;
+	double a33 = 0;
+
+	void addPlane(double a, double b, double c, double d)
+	{
+		a00 += a * a; a01 += a * b; a02 += a * c; a03 += a * d;
+		a11 += b * b; a12 += b * c; a13 += b * d;
+		a22 += c * c; a23 += c * d;
+		a33 += d * d;
+	}
+
+	void add(const Quadric& q)
+	{
+		a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+		a11 += q.a11; a12 += q.a12; a13 += q.a13;
+		a22 += q.a22; a23 += q.a23;
+		a33 += q.a33;
+	}
+
+	// Sum of squared distances from p to the planes
+	double error(const glm::vec3& p) const
+	{
+		double x = p.x, y = p.y, z = p.z;
+		double result = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x
+			+ a11 * y * y + 2 * a12 * y * z + 2 * a13 * y
+			+ a22 * z * z + 2 * a23 * z
+			+ a33;
+		return std::max(result, 0.0);
+	}
+};
+
+struct Collapse
+{
+	unsigned int from;
+	unsigned int to;
+	double cost;
+};
+
+static uint64_t edgeKey(unsigned int a, unsigned int b)
+{
+	if (a > b)
+		std::swap(a, b);
+	return (uint64_t(a) << 32) | b;
+}
+
+// Vertices at the same position, such as the copies of a vertex on a UV or normal seam. They only
+// ever move together, so a seam never opens up.
+struct PositionGroups
+{
+	std::vector<unsigned int> group;		// Of every vertex
+	std::vector<unsigned int> offsets;		// members[offsets[g]] to members[offsets[g + 1]] are in group g
+	std::vector<unsigned int> members;
+	std::vector<unsigned char> locked;		// Of every group, on an edge used by only one triangle (open borders)
+};
+
+static PositionGroups findPositionGroups(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+{
+	struct PositionHash {
+		size_t operator()(const glm::vec3& p) const
+		{
+			uint32_t bits[3];
+			std::memcpy(bits, &p, sizeof(bits));
+			return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+		}
+	};
+
+	// Weld by exact position
+	PositionGroups groups;
+	groups.group.resize(vertices.size());
+	std::unordered_map<glm::vec3, unsigned int, PositionHash> groupAtPosition;
+	groupAtPosition.reserve(vertices.size());
+	for (unsigned int i = 0; i < vertices.size(); i++)
+		groups.group[i] = groupAtPosition.emplace(vertices[i].position, static_cast<unsigned int>(groupAtPosition.size())).first->second;
+
+	size_t groupCount = groupAtPosition.size();
+	groups.offsets.assign(groupCount + 1, 0);
+	for (unsigned int group : groups.group)
+		groups.offsets[group + 1]++;
+	for (size_t i = 1; i < groups.offsets.size(); i++)
+		groups.offsets[i] += groups.offsets[i - 1];
+	groups.members.resize(vertices.size());
+	std::vector<unsigned int> cursor(groups.offsets.begin(), groups.offsets.end() - 1);
+	for (unsigned int i = 0; i < vertices.size(); i++)
+		groups.members[cursor[groups.group[i]]++] = i;
+
+	std::unordered_map<uint64_t, unsigned int> edgeUses;
+	edgeUses.reserve(indices.size());
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		for (int e = 0; e < 3; e++)
+			edgeUses[edgeKey(groups.group[indices[i + e]], groups.group[indices[i + (e + 1) % 3]])]++;
+	}
+
+	groups.locked.assign(groupCount, 0);
+	for (const auto& edge : edgeUses)
+	{
+		if (edge.second == 1)
+		{
+			groups.locked[edge.first >> 32] = 1;
+			groups.locked[edge.first & 0xFFFFFFFF] = 1;
+		}
+	}
+	return groups;
+}
+
+std::vector<unsigned int> simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, size_t targetIndexCount,
+	float maxError, float* resultError)
+{
+	std::vector<unsigned int> result = indices;
+	double worstCost = 0.0;
+	double maxCost = double(maxError) * maxError;
+	if (resultError)
+		*resultError = 0.f;
+	if (indices.size() <= targetIndexCount || vertices.empty())
+		return result;
+
+	PositionGroups groups = findPositionGroups(vertices, indices);
+	size_t groupCount = groups.locked.size();
+
+	// Quadric of the planes of every triangle around each vertex
+	std::vector<Quadric> quadrics(vertices.size());
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		const glm::vec3& p0 = vertices[indices[i]].position;
+		glm::vec3 normal = glm::cross(vertices[indices[i + 1]].position - p0, vertices[indices[i + 2]].position - p0);
+		float length = glm::length(normal);
+		if (length == 0.f)
+			continue;
+		normal /= length;
+
+		double d = -glm::dot(normal, p0);
+		for (int corner = 0; corner < 3; corner++)
+			quadrics[indices[i + corner]].addPlane(normal.x, normal.y, normal.z, d);
+	}
+
+	std::vector<unsigned int> remap(vertices.size());
+	std::vector<unsigned char> touched(vertices.size());
+	std::vector<unsigned int> triangleOffsets(vertices.size() + 1);
+	std::vector<unsigned int> vertexTriangles;
+	std::vector<Quadric> groupQuadrics(groupCount);
+	std::vector<Collapse> candidates;
+	std::unordered_map<uint64_t, unsigned char> seenCandidates;
+	std::vector<std::pair<unsigned int, unsigned int>> moves;
+
+	// Each pass collapses the cheapest independent edges, then rewrites the index list. A collapse
+	// moves every vertex of one position group onto a vertex of a neighbouring group it shares an
+	// edge with.
+	while (result.size() > targetIndexCount)
+	{
+		size_t triangleCount = result.size() / 3;
+
+		// Triangles around every vertex
+		std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+		for (unsigned int index : result)
+			triangleOffsets[index + 1]++;
+		for (size_t i = 1; i < triangleOffsets.size(); i++)
+			triangleOffsets[i] += triangleOffsets[i - 1];
+		vertexTriangles.resize(result.size());
+		std::vector<unsigned int> cursor(triangleOffsets.begin(), triangleOffsets.end() - 1);
+		for (size_t i = 0; i < result.size(); i++)
+			vertexTriangles[cursor[result[i]]++] = static_cast<unsigned int>(i / 3);
+		auto isUsed = [&](unsigned int vertex) { return triangleOffsets[vertex + 1] > triangleOffsets[vertex]; };
+
+		// Quadric of every group, over the vertices still in use
+		std::fill(groupQuadrics.begin(), groupQuadrics.end(), Quadric());
+		for (unsigned int i = 0; i < vertices.size(); i++)
+		{
+			if (isUsed(i))
+				groupQuadrics[groups.group[i]].add(quadrics[i]);
+		}
+
+		// Every edge between two groups in both directions, away from a group that may move
+		candidates.clear();
+		seenCandidates.clear();
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			for (int e = 0; e < 3; e++)
+			{
+				unsigned int a = result[i + e], b = result[i + (e + 1) % 3];
+				unsigned int groupA = groups.group[a], groupB = groups.group[b];
+				if (groupA == groupB)
+					continue;
+				auto addCandidate = [&](unsigned int from, unsigned int to, unsigned int fromGroup, unsigned int toGroup) {
+					if (groups.locked[fromGroup] || !seenCandidates.emplace((uint64_t(fromGroup) << 32) | toGroup, 1).second)
+						return;
+					Quadric quadric = groupQuadrics[fromGroup];
+					quadric.add(groupQuadrics[toGroup]);
+					candidates.push_back(Collapse{ from, to, quadric.error(vertices[to].position) });
+				};
+				addCandidate(a, b, groupA, groupB);
+				addCandidate(b, a, groupB, groupA);
+			}
+		}
+		std::sort(candidates.begin(), candidates.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+		// Each collapse removes about two triangles
+		size_t collapseBudget = (triangleCount - targetIndexCount / 3) / 2 + 1;
+		size_t collapses = 0;
+		for (unsigned int i = 0; i < remap.size(); i++)
+			remap[i] = i;
+		std::fill(touched.begin(), touched.end(), 0);
+
+		for (const Collapse& collapse : candidates)
+		{
+			if (collapses >= collapseBudget || collapse.cost > maxCost)
+				break;
+
+			// Every vertex of the group needs a neighbour in the target group to move onto, or the
+			// surface would tear along the seam
+			unsigned int fromGroup = groups.group[collapse.from], toGroup = groups.group[collapse.to];
+			const glm::vec3& target = vertices[collapse.to].position;
+			moves.clear();
+			bool valid = true;
+			for (unsigned int m = groups.offsets[fromGroup]; m < groups.offsets[fromGroup + 1] && valid; m++)
+			{
+				unsigned int vertex = groups.members[m];
+				if (!isUsed(vertex))
+					continue;
+
+				unsigned int destination = vertex;
+				for (unsigned int t = triangleOffsets[vertex]; t < triangleOffsets[vertex + 1] && destination == vertex; t++)
+				{
+					const unsigned int* triangle = &result[vertexTriangles[t] * 3];
+					for (int corner = 0; corner < 3; corner++)
+					{
+						if (groups.group[triangle[corner]] == toGroup)
+							destination = triangle[corner];
+					}
+				}
+				valid = destination != vertex && !touched[vertex] && !touched[destination];
+				moves.emplace_back(vertex, destination);
+			}
+			if (!valid || moves.empty())
+				continue;
+
+			// Moving the vertices must not flip any triangle that survives the collapse
+			bool flips = false;
+			for (size_t m = 0; m < moves.size() && !flips; m++)
+			{
+				unsigned int vertex = moves[m].first, destination = moves[m].second;
+				for (unsigned int t = triangleOffsets[vertex]; t < triangleOffsets[vertex + 1] && !flips; t++)
+				{
+					const unsigned int* triangle = &result[vertexTriangles[t] * 3];
+					if (triangle[0] == destination || triangle[1] == destination || triangle[2] == destination)
+						continue;
+
+					glm::vec3 before[3], after[3];
+					for (int corner = 0; corner < 3; corner++)
+					{
+						before[corner] = vertices[triangle[corner]].position;
+						after[corner] = groups.group[triangle[corner]] == fromGroup ? target : before[corner];
+					}
+					glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+					glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+					flips = glm::dot(normalBefore, normalAfter) <= 0.f;
+				}
+			}
+			if (flips)
+				continue;
+
+			// Freeze the neighbourhood for the rest of the pass, so the flip test above stays valid
+			for (const auto& move : moves)
+			{
+				for (unsigned int t = triangleOffsets[move.first]; t < triangleOffsets[move.first + 1]; t++)
+				{
+					const unsigned int* triangle = &result[vertexTriangles[t] * 3];
+					touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+				}
+				remap[move.first] = move.second;
+				quadrics[move.second].add(quadrics[move.first]);
+			}
+			worstCost = std::max(worstCost, collapse.cost);
+			collapses++;
+		}
+		if (collapses == 0)
+			break;
+
+		// Rewrite the index list and drop triangles that collapsed to a line
+		size_t write = 0;
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			unsigned int a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+			if (a == b || b == c || a == c)
+				continue;
+			result[write++] = a;
+			result[write++] = b;
+			result[write++] = c;
+		}
+		result.resize(write);
+	}
+
+	if (resultError)
+		*resultError = static_cast<float>(std::sqrt(worstCost));
+	return result;
+}
+
+void generateLods(MeshData& data)
+{
+	data.lods.clear();
+	if (data.indices.size() < MIN_LOD_INDICES || data.bounds.isEmpty())
+		return;
+
+	float maxError = glm::length(data.bounds.max - data.bounds.min) * MAX_LOD_ERROR;
+	const std::vector<unsigned int>* previous = &data.indices;
+	float previousError = 0.f;
+
+	// Every level is simplified from the one before, so its error is bounded by the sum of both
+	for (unsigned int level = 1; level < MAX_MESH_LODS; level++)
+	{
+		size_t target = previous->size() / 6 * 3;
+		float error = 0.f;
+		std::vector<unsigned int> indices = simplifyMesh(data.vertices, *previous, target, maxError - previousError, &error);
+		if (indices.empty() || indices.size() > previous->size() * (1.f - MIN_LOD_REDUCTION))
+			break;
+		optimizeVertexCache(indices, data.vertices.size());
+
+		data.lods.push_back(LodData{ std::move(indices), previousError + error });
+		previous = &data.lods.back().indices;
+		previousError = data.lods.back().error;
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <vector>
+#include "mesh_data.h"
+
+/*
+	Quadric error metric simplification by edge collapse (Garland & Heckbert), restricted to
+	collapsing a vertex onto one of its neighbours. The vertex buffer is never changed, only a new
+	index list is produced, so every level of detail of a mesh draws from the same vertices.
+
+	Vertices on an open border are never moved, which keeps silhouettes of open meshes intact.
+	Vertices on a UV or normal seam (several vertices at the same position) only move together, each
+	onto a neighbour at one shared position, so texture seams never open.
+
+	The returned error is the largest distance, in the vertices' units, between the simplified
+	surface and the planes of the original triangles that were collapsed into it.
+*/
+
+// Simplify a triangle list towards targetIndexCount indices, without exceeding maxError. Returns the
+// simplified index list, which may have more indices than asked for if the error limit was reached.
+std::vector<unsigned int> simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, size_t targetIndexCount,
+	float maxError, float* resultError = nullptr);
+
+// Fill data.lods with successively coarser index lists of data, each about half the previous one
+// and reordered for the vertex cache
+void generateLods(MeshData& data);
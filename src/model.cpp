@@ -1,193 +1,485 @@
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <map>
 #include <glm/glm.hpp>
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
-#include <stb_image.h>
+#include "shader.cpp"
 #include "model.h"
 #include "mesh.h"
+#include "model_cache.h"
+#include "thread_pool.h"
+#include "texture_loader.h"
 
-// Constructor given path to model file
-Model::Model(std::string const& path)
+// Constructor given path to model file, and the layout its vertices are kept in on the GPU
+Model::Model(std::string const& path, VertexFormat vertexFormat)
+	: vertexFormat(vertexFormat)
 {
 	loadModel(path);
+	setupBatches();
+	setupCulling();
 }
 
-// Draw each individual mesh of the model
+// Mark the meshes whose bounds are outside the frustum so draw() skips them. The frustum is moved
+// into object space once, so the BVH is walked with the untransformed bounds.
+void Model::cull(const Frustum& frustum, const glm::mat4& modelMatrix)
+{
+	Frustum objectFrustum = frustum.inObjectSpace(modelMatrix);
+	bvh.cull(objectFrustum, meshVisible.data());
+
+	// Occlusion queries draw the boxes with the same transform and need the near plane
+	cullModelMatrix = modelMatrix;
+	cullNearPlane = objectFrustum.planes[4];
+}
+
+// Skip meshes whose bounding box was hidden behind the depth buffer of an earlier frame. Results
+// are only waited for if asked, e.g. for deterministic headless runs.
+void Model::setOcclusionCulling(bool enabled, bool waitForResults)
+{
+	waitForOcclusion = waitForResults;
+	if (!enabled)
+	{
+		occlusionQueries.reset();
+		return;
+	}
+	if (!occlusionQueries)
+	{
+		occlusionQueries = std::make_unique<OcclusionQueries>();
+		occlusionQueries->resize(meshes.size());
+	}
+}
+
+// Draw the model out of the shared buffers, one multi-draw per material. With occlusion culling on,
+// the boxes of the meshes that passed frustum culling are then tested against the depth buffer the
+// model was just drawn into, and their results pick the meshes drawn in a later frame.
 void Model::draw(Shader& shader)
 {
+	if (occlusionQueries)
+		occlusionQueries->collectResults(waitForOcclusion);
+	buildDrawCommands();
+
+	if (vertexFormat == VertexFormat::Quantized)
+	{
+		if (dequantizationProgram != shader.ID)
+		{
+			positionOffsetLoc = shader.getUniformLocation("positionOffset");
+			positionScaleLoc = shader.getUniformLocation("positionScale");
+			dequantizationProgram = shader.ID;
+		}
+		shader.setVec3(positionOffsetLoc, positionDequantization.offset);
+		shader.setVec3(positionScaleLoc, positionDequantization.scale);
+	}
+
+	glBindVertexArray(VAO);
+	submitDrawCommands(shader);
+	glBindVertexArray(0);
+
+	if (occlusionQueries)
+	{
+		occlusionQueries->issue(meshBounds, meshVisible.data(), cullModelMatrix, cullNearPlane);
+		cullStats.occlusionQueries = occlusionQueries->getQueriesIssued();
+
+		// The boxes were drawn with their own program
+		shader.use();
+	}
+}
+
+// Pick the coarsest level of detail of every mesh whose simplification error, projected onto the
+// screen at the distance of the mesh's bounding sphere, stays under pixelThreshold pixels. Meshes
+// the camera is inside of are always drawn at full resolution.
+void Model::selectLods(const glm::vec3& cameraPosition, float fovY, float viewportHeight, const glm::mat4& modelMatrix, float pixelThreshold)
+{
+	// Pixels covered by one world unit at distance 1, and the largest scale the model matrix applies
+	float pixelsPerUnit = viewportHeight / (2.f * std::tan(fovY * .5f));
+	float maxScale = std::max({ glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2])) });
+
 	for (unsigned int i = 0; i < meshes.size(); i++)
-		meshes[i].draw(shader);
+	{
+		const Mesh& mesh = meshes[i];
+		glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(mesh.sphere.center, 1.f));
+		float distance = glm::length(center - cameraPosition) - mesh.sphere.radius * maxScale;
+
+		unsigned char lod = 0;
+		if (distance > 0.f)
+		{
+			while (lod + 1u < mesh.lodCount && mesh.lods[lod + 1].error * maxScale * pixelsPerUnit / distance <= pixelThreshold)
+				lod++;
+		}
+		selectedLod[i] = lod;
+	}
 }
 
-// Load model into Scene object
-void Model::loadModel(std::string path)
+// Nearest mesh whose bounds a world space ray hits. This picks by bounding box, not by triangle.
+bool Model::pick(const glm::vec3& origin, const glm::vec3& direction, const glm::mat4& modelMatrix, unsigned int& mesh, float& distance) const
 {
-	Assimp::Importer importer;
-	const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
-	if (!scene || !scene->mRootNode || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE)
+	glm::mat4 inverseModel = glm::inverse(modelMatrix);
+	glm::vec3 objectOrigin = glm::vec3(inverseModel * glm::vec4(origin, 1.f));
+	glm::vec3 objectDirection = glm::vec3(inverseModel * glm::vec4(direction, 0.f));
+
+	float objectDistance;
+	if (!bvh.raycast(objectOrigin, objectDirection, INFINITY, mesh, objectDistance))
+		return false;
+
+	// Measure the distance in world space, the model matrix may scale
+	glm::vec3 hit = glm::vec3(modelMatrix * glm::vec4(objectOrigin + objectDirection * objectDistance, 1.f));
+	distance = glm::length(hit - origin);
+	return true;
+}
+
+// World space bounds of every mesh that survived the last cull()
+void Model::appendVisibleBounds(std::vector<AABB>& worldBounds, const glm::mat4& modelMatrix) const
+{
+	for (unsigned int i = 0; i < meshes.size(); i++)
 	{
-		std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
-		return;
+		if (meshVisible[i])
+			worldBounds.push_back(meshes[i].bounds.transformed(modelMatrix));
+	}
+}
+
+// Group meshes by material so each material is bound once per frame
+void Model::setupBatches()
+{
+	// Meshes with identical texture lists share a material
+	std::map<std::vector<unsigned int>, unsigned int> materials;
+	for (unsigned int i = 0; i < meshes.size(); i++)
+	{
+		std::vector<unsigned int> textureIDs;
+		for (const Texture& texture : meshes[i].textures)
+			textureIDs.push_back(texture.id);
+
+		auto it = materials.emplace(textureIDs, static_cast<unsigned int>(materials.size())).first;
+		meshes[i].materialID = it->second;
 	}
 
-	directory = path.substr(0, path.find_last_of('/'));
+	drawOrder.resize(meshes.size());
+	for (unsigned int i = 0; i < meshes.size(); i++)
+		drawOrder[i] = i;
+	std::stable_sort(drawOrder.begin(), drawOrder.end(), [this](unsigned int a, unsigned int b) {
+		return meshes[a].materialID < meshes[b].materialID;
+	});
 
-	processNode(scene->mRootNode, scene);
+#ifdef GL_VERSION_4_3
+	useIndirect = GLAD_GL_VERSION_4_3;
+	if (useIndirect)
+		glGenBuffers(1, &indirectBuffer);
+#endif
 }
 
-// Recursively process each node in a Scene object to process their meshes
-void Model::processNode(aiNode* node, const aiScene* scene)
+// Build the BVH over the mesh bounds and link meshes to their nodes. Everything is visible until the first cull.
+void Model::setupCulling()
 {
-	// Process all meshes in node
-	for (unsigned int i = 0; i < node->mNumMeshes; i++)
+	meshBounds.clear();
+	bounds = AABB();
+	for (const Mesh& mesh : meshes)
 	{
-		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-		meshes.push_back(processMesh(mesh, scene));
+		meshBounds.push_back(mesh.bounds);
+		bounds.grow(mesh.bounds);
 	}
+	bvh.build(meshBounds);
+	meshVisible.assign(meshes.size(), 1);
+	selectedLod.assign(meshes.size(), 0);
 
-	// Process all children of current node
-	for (unsigned int i = 0; i < node->mNumChildren; i++)
-		processNode(node->mChildren[i], scene);
+	for (unsigned int i = 0; i < nodes.size(); i++)
+	{
+		for (unsigned int j = nodes[i].firstMesh; j < nodes[i].firstMesh + nodes[i].meshCount && j < meshes.size(); j++)
+			meshes[j].node = i;
+	}
 }
 
-// Construct a Mesh from vertices, indices, and materials, given an aiMesh from a Scene object
-Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
+// Fill one draw command per visible mesh, in material order, and split them into batches
+void Model::buildDrawCommands()
 {
-	std::vector<Vertex> vertices;
-	std::vector<unsigned int> indices;
-	std::vector<Texture> textures;
+	drawCommands.clear();
+	drawBatches.clear();
+	cullStats = CullStats();
 
-	// Process vertices
-	for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+	for (unsigned int i : drawOrder)
 	{
-		Vertex vertex;
+		if (!meshVisible[i])
+		{
+			cullStats.culledMeshes++;
+			continue;
+		}
+		if (occlusionQueries && !occlusionQueries->isVisible(i))
+		{
+			cullStats.occludedMeshes++;
+			continue;
+		}
+		cullStats.drawnMeshes++;
 
-		// Position
-		glm::vec3 vector;
-		vector.x = mesh->mVertices[i].x;
-		vector.y = mesh->mVertices[i].y;
-		vector.z = mesh->mVertices[i].z;
-		vertex.position = vector;
+		const Mesh& mesh = meshes[i];
+		if (drawBatches.empty() || meshes[drawBatches.back().mesh].materialID != mesh.materialID)
+			drawBatches.push_back(DrawBatch{ i, static_cast<unsigned int>(drawCommands.size()), 0 });
 
-		// Normal
-		vector.x = mesh->mNormals[i].x;
-		vector.y = mesh->mNormals[i].y;
-		vector.z = mesh->mNormals[i].z;
-		vertex.normal = vector;
+		const MeshLod& lod = mesh.lods[selectedLod[i]];
+		drawCommands.push_back(DrawElementsIndirectCommand{ lod.indexCount, 1, lod.firstIndex, static_cast<int>(mesh.baseVertex), 0 });
+		cullStats.drawnTriangles += lod.indexCount / 3;
+		drawBatches.back().commandCount++;
+	}
 
-		// Texture coordinates
-		if (mesh->mTextureCoords[0])
+	if (!useIndirect)
+	{
+		drawCounts.clear();
+		drawOffsets.clear();
+		drawBaseVertices.clear();
+		for (const DrawElementsIndirectCommand& command : drawCommands)
 		{
-			glm::vec2 vec;
-			vec.x = mesh->mTextureCoords[0][i].x;
-			vec.y = mesh->mTextureCoords[0][i].y;
-			vertex.texCoords = vec;
+			drawCounts.push_back(command.count);
+			drawOffsets.push_back((void*)(command.firstIndex * indexSize));
+			drawBaseVertices.push_back(command.baseVertex);
 		}
-		else
-			vertex.texCoords = glm::vec2(0.f, 0.f);
+	}
+}
 
-		vertices.push_back(vertex);
+// Bind each batch's material and submit all of its commands with a single call
+void Model::submitDrawCommands(Shader& shader)
+{
+	cullStats.drawCalls = static_cast<unsigned int>(drawBatches.size());
+
+#ifdef GL_VERSION_4_3
+	if (useIndirect)
+	{
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, drawCommands.size() * sizeof(DrawElementsIndirectCommand), drawCommands.data(), GL_STREAM_DRAW);
+		for (const DrawBatch& batch : drawBatches)
+		{
+			meshes[batch.mesh].bindTextures(shader);
+			cullStats.textureBinds += static_cast<unsigned int>(meshes[batch.mesh].textures.size());
+			glMultiDrawElementsIndirect(GL_TRIANGLES, indexType, (void*)(batch.firstCommand * sizeof(DrawElementsIndirectCommand)), batch.commandCount, 0);
+		}
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		glActiveTexture(GL_TEXTURE0);
+		return;
 	}
+#endif
 
-	// Process indices
-	for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+	for (const DrawBatch& batch : drawBatches)
 	{
-		aiFace face = mesh->mFaces[i];
-		for (unsigned int j = 0; j < face.mNumIndices; j++)
-			indices.push_back(face.mIndices[j]);
+		meshes[batch.mesh].bindTextures(shader);
+		cullStats.textureBinds += static_cast<unsigned int>(meshes[batch.mesh].textures.size());
+		glMultiDrawElementsBaseVertex(GL_TRIANGLES, &drawCounts[batch.firstCommand], indexType, &drawOffsets[batch.firstCommand],
+			batch.commandCount, &drawBaseVertices[batch.firstCommand]);
 	}
+	glActiveTexture(GL_TEXTURE0);
+}
+
+// Counters of the Assimp import this model was built from. All zero if it was mapped from a packed model or cache.
+const ImportStats& Model::getImportStats() const
+{
+	return importStats;
+}
+
+// Load model from a packed model or its mesh cache, or import it into a Scene object and fill the cache
+void Model::loadModel(std::string path)
+{
+	directory = path.substr(0, path.find_last_of('/'));
 
-	// Process material
-	if (mesh->mMaterialIndex >= 0)
+	// Packed models and up to date caches are mapped and uploaded without any CPU side copy
+	PackedModel packed;
+	if (isPackedModelPath(path))
+	{
+		if (packed.open(path))
+			loadPacked(packed);
+		else
+			std::cout << "ERROR::PACKED_MODEL::Could not open " << path << std::endl;
+		return;
+	}
+	if (openModelCache(path, MODEL_IMPORT_FLAGS, packed))
 	{
-		aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+		loadPacked(packed);
+		return;
+	}
 
-		std::vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-		textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+	// Import on the CPU, then upload
+	ImportedModel imported;
+	if (!importModel(path, imported))
+		return;
+	writeModelCache(path, MODEL_IMPORT_FLAGS, imported.sourceFiles, imported.meshes, imported.nodes);
+	nodes = std::move(imported.nodes);
+	importStats = imported.stats;
+	const std::vector<MeshData>& meshData = imported.meshes;
 
-		std::vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-		textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+	// Upload meshes back to back into the shared buffers, each with its LODs after its own indices
+	size_t vertexCount = 0, indexCount = 0;
+	AABB modelBounds;
+	setIndexSize(sizeof(uint16_t));
+	for (unsigned int i = 0; i < meshData.size(); i++)
+	{
+		if (meshData[i].vertices.size() > MAX_SHORT_INDEX_VERTICES)
+			setIndexSize(sizeof(unsigned int));
+		modelBounds.grow(meshData[i].bounds);
+		vertexCount += meshData[i].vertices.size();
+		indexCount += meshData[i].indices.size();
+		for (const LodData& lod : meshData[i].lods)
+			indexCount += lod.indices.size();
 	}
+	positionDequantization = makePositionDequantization(modelBounds);
+	setupBuffers(nullptr, vertexCount, nullptr, indexCount);
+
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	unsigned int baseVertex = 0, firstIndex = 0;
+	for (unsigned int i = 0; i < meshData.size(); i++)
+	{
+		const MeshData& data = meshData[i];
+		uploadVertices(data.vertices.data(), data.vertices.size(), baseVertex);
+		uploadIndices(data.indices, firstIndex);
 
-	return Mesh(vertices, indices, textures);
+		meshes.push_back(Mesh(baseVertex, firstIndex, static_cast<unsigned int>(data.indices.size()), loadTextures(data.textures)));
+		meshes.back().indexType = indexType;
+		meshes.back().bounds = data.bounds;
+		meshes.back().sphere = data.sphere;
+		baseVertex += static_cast<unsigned int>(data.vertices.size());
+		firstIndex += static_cast<unsigned int>(data.indices.size());
+
+		for (unsigned int lod = 0; lod < data.lods.size() && lod + 1 < MAX_MESH_LODS; lod++)
+		{
+			const std::vector<unsigned int>& indices = data.lods[lod].indices;
+			uploadIndices(indices, firstIndex);
+			meshes.back().lods[lod + 1] = MeshLod{ firstIndex, static_cast<unsigned int>(indices.size()), data.lods[lod].error };
+			meshes.back().lodCount++;
+			firstIndex += static_cast<unsigned int>(indices.size());
+		}
+	}
+	glBindVertexArray(0);
 }
 
-// Load and generate texture from file, and return ID to it
-unsigned int Model::TextureFromFile(const char* path, const std::string& directory, bool gamma)
+// Upload meshes straight from a mapped packed model. Its blobs already hold every mesh back to back,
+// so they go into the shared buffers with one glBufferData each. The mapping can be dropped right after.
+void Model::loadPacked(const PackedModel& packed)
 {
-	std::string filename = std::string(path);
-	filename = directory + '/' + filename;
+	const PackedHeader& header = packed.header();
+	const PackedMesh* packedMeshes = packed.meshes();
+
+	AABB modelBounds;
+	for (unsigned int i = 0; i < header.meshCount; i++)
+	{
+		AABB meshBounds;
+		meshBounds.min = glm::vec3(packedMeshes[i].boundsMin[0], packedMeshes[i].boundsMin[1], packedMeshes[i].boundsMin[2]);
+		meshBounds.max = glm::vec3(packedMeshes[i].boundsMax[0], packedMeshes[i].boundsMax[1], packedMeshes[i].boundsMax[2]);
+		modelBounds.grow(meshBounds);
+	}
+	positionDequantization = makePositionDequantization(modelBounds);
 
-	unsigned int textureID;
-	glGenTextures(1, &textureID);
+	setIndexSize(header.indexSize);
+	setupBuffers(packed.vertices(), header.vertexCount, packed.indices(), header.indexCount);
+	nodes = packed.nodes();
 
-	int width, height, nrComponents;
-	unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-	if (data)
+	for (unsigned int i = 0; i < header.meshCount; i++)
 	{
-		GLenum format;
-		if (nrComponents == 1)
-			format = GL_RED;
-		else if (nrComponents == 3)
-			format = GL_RGB;
-		else if (nrComponents == 4)
-			format = GL_RGBA;
+		const PackedMesh& mesh = packedMeshes[i];
+		meshes.push_back(Mesh(mesh.firstVertex, mesh.firstIndex, mesh.indexCount, loadTextures(packed.textures(mesh))));
+		meshes.back().indexType = indexType;
+		meshes.back().bounds.min = glm::vec3(mesh.boundsMin[0], mesh.boundsMin[1], mesh.boundsMin[2]);
+		meshes.back().bounds.max = glm::vec3(mesh.boundsMax[0], mesh.boundsMax[1], mesh.boundsMax[2]);
+		meshes.back().sphere.center = glm::vec3(mesh.sphereCenter[0], mesh.sphereCenter[1], mesh.sphereCenter[2]);
+		meshes.back().sphere.radius = mesh.sphereRadius;
+
+		for (unsigned int lod = 1; lod < mesh.lodCount; lod++)
+			meshes.back().lods[lod] = MeshLod{ mesh.lodFirstIndex[lod - 1], mesh.lodIndexCount[lod - 1], mesh.lodError[lod - 1] };
+		meshes.back().lodCount = mesh.lodCount;
+	}
+}
+
+// Create the vertex array and the vertex/index buffers shared by all meshes, in the model's vertex
+// format. Data may be null to only allocate them.
+void Model::setupBuffers(const Vertex* vertices, size_t vertexCount, const void* indices, size_t indexCount)
+{
+	// Generate buffers
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &VBO);
+	glGenBuffers(1, &EBO);
 
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
+	// Bind buffers
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	// Buffer data
+	// NOTE: Memory of structs in C++ are consecutive like arrays. Therefore, we can reference the struct
+	// the same way we did with plain arrays!
+	size_t vertexSize = getVertexSize(vertexFormat);
+	glBufferData(GL_ARRAY_BUFFER, vertexCount * vertexSize, vertexFormat == VertexFormat::Float ? vertices : nullptr, GL_STATIC_DRAW);
+	if (vertexFormat != VertexFormat::Float && vertices)
+		uploadVertices(vertices, vertexCount, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * indexSize, indices, GL_STATIC_DRAW);
 
-		stbi_image_free(data);
+	// Vertex position, normal, texture coord
+	if (vertexFormat == VertexFormat::Quantized)
+	{
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(QuantizedVertex), (void*)offsetof(QuantizedVertex, position));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(QuantizedVertex), (void*)offsetof(QuantizedVertex, normal));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(QuantizedVertex), (void*)offsetof(QuantizedVertex, texCoords));
+		glBindVertexArray(0);
+		return;
 	}
-	else
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal)); // using offsetof to measure distance of bytes between Vertex and its member Normal
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
+
+	glBindVertexArray(0);
+}
+
+// Write count vertices at baseVertex of the bound vertex buffer, converted to the model's vertex format
+void Model::uploadVertices(const Vertex* vertices, size_t count, size_t baseVertex)
+{
+	if (vertexFormat == VertexFormat::Float)
 	{
-		std::cout << "ERROR::STBI_IMAGE::Texture failed to load at path: " << path << std::endl;
-		stbi_image_free(data);
+		glBufferSubData(GL_ARRAY_BUFFER, baseVertex * sizeof(Vertex), count * sizeof(Vertex), vertices);
+		return;
 	}
 
-	return textureID;
+	std::vector<QuantizedVertex> quantized(count);
+	quantizeVertices(vertices, count, positionDequantization, quantized.data());
+	glBufferSubData(GL_ARRAY_BUFFER, baseVertex * sizeof(QuantizedVertex), count * sizeof(QuantizedVertex), quantized.data());
 }
 
-// Get list of textures from index material
-std::vector<Texture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName)
+// Write indices at firstIndex of the bound index buffer, narrowed to 16 bits if the model uses them
+void Model::uploadIndices(const std::vector<unsigned int>& indices, size_t firstIndex)
 {
-	std::vector<Texture> textures;
-	for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
+	if (indexType == GL_UNSIGNED_INT)
 	{
-		// Get texture file location
-		aiString str;
-		mat->GetTexture(type, i, &str);
-		bool skip = false;
+		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, firstIndex * sizeof(unsigned int), indices.size() * sizeof(unsigned int), indices.data());
+		return;
+	}
 
-		// Check if texture is already loaded
-		for (unsigned int j = 0; j < texturesLoaded.size(); j++)
-		{
-			if (std::strcmp(texturesLoaded[j].path.data(), str.C_Str()) == 0)
-			{
-				textures.push_back(texturesLoaded[j]);
-				skip = true;
-				break;
-			}
-		}
+	std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, firstIndex * sizeof(uint16_t), shortIndices.size() * sizeof(uint16_t), shortIndices.data());
+}
 
-		// Otherwise, load it
-		if (!skip)
-		{
-			// Construct texture
-			Texture texture;
-			texture.id = TextureFromFile(str.C_Str(), directory);
-			texture.type = typeName;
-			texture.path = str.C_Str();
-
-			textures.push_back(texture);
-			texturesLoaded.push_back(texture);
-		}
-		
+void Model::setIndexSize(size_t size)
+{
+	indexSize = size;
+	indexType = size == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+// Get texture registered for file, or generate it and queue its decode, and return ID to it. A
+// placeholder image is shown until TextureLoader::processUploads() has uploaded the decoded file.
+unsigned int Model::TextureFromFile(const char* path, const std::string& directory, bool gamma)
+{
+	std::string filename = std::string(path);
+	filename = directory + '/' + filename;
+
+	return TextureLoader::shared().load(filename);
+}
+
+// Get list of textures from their references. Files already loaded by any model are shared.
+std::vector<Texture> Model::loadTextures(const std::vector<TextureRef>& refs)
+{
+	std::vector<Texture> textures;
+	textures.reserve(refs.size());
+	for (unsigned int i = 0; i < refs.size(); i++)
+	{
+		Texture texture;
+		texture.id = TextureFromFile(refs[i].path.c_str(), directory);
+		texture.type = refs[i].type;
+		texture.path = refs[i].path;
+		textures.push_back(texture);
 	}
 	return textures;
-}
+}
\ No newline at end of file
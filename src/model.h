@@ -1,29 +1,117 @@
 #pragma once
+#include <memory>
 #include <vector>
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include "shader.cpp"
+#include "bounds.h"
+#include "bvh.h"
 #include "mesh.h"
+#include "model_import.h"
+#include "occlusion_queries.h"
+#include "packed_model.h"
+#include "vertex_format.h"
+
+// Meshes drawn and skipped by frustum and occlusion culling in the last draw, and the GL work of drawing them
+struct CullStats {
+	unsigned int drawnMeshes = 0;
+	unsigned int drawnTriangles = 0;	// At the selected LODs
+	unsigned int culledMeshes = 0;
+	unsigned int occludedMeshes = 0;
+	unsigned int occlusionQueries = 0;
+	unsigned int drawCalls = 0;		// Multi-draw submissions, one per material batch
+	unsigned int textureBinds = 0;
+};
+
+// Command layout read by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+	unsigned int count;
+	unsigned int instanceCount;
+	unsigned int firstIndex;
+	int baseVertex;
+	unsigned int baseInstance;
+};
+
+// Consecutive draw commands that share one material
+struct DrawBatch {
+	unsigned int mesh;	// Any mesh of the batch, to bind the material from
+	unsigned int firstCommand;
+	unsigned int commandCount;
+};
 
 class Model
 {
 public:
 	// Constructor
-	Model(std::string const &path);
+	Model(std::string const &path, VertexFormat vertexFormat = VertexFormat::Float);
 
 	// Methods
+	void cull(const Frustum& frustum, const glm::mat4& modelMatrix);
 	void draw(Shader& shader);
+	void setOcclusionCulling(bool enabled, bool waitForResults = false);
+	void selectLods(const glm::vec3& cameraPosition, float fovY, float viewportHeight, const glm::mat4& modelMatrix, float pixelThreshold = 1.f);
+	void appendVisibleBounds(std::vector<AABB>& worldBounds, const glm::mat4& modelMatrix) const;
+	bool pick(const glm::vec3& origin, const glm::vec3& direction, const glm::mat4& modelMatrix, unsigned int& mesh, float& distance) const;
+	const ImportStats& getImportStats() const;
+	const CullStats& getCullStats() const { return cullStats; }
+	const AABB& getBounds() const { return bounds; }
+	VertexFormat getVertexFormat() const { return vertexFormat; }
+	const std::vector<ModelNode>& getNodes() const { return nodes; }
+	unsigned int getMeshNode(unsigned int mesh) const { return meshes[mesh].node; }
+	const BVH& getBVH() const { return bvh; }
 
 private:
 	// Properties
 	std::vector<Mesh> meshes;
+	std::vector<ModelNode> nodes;
 	std::string directory;
-	std::vector<Texture> texturesLoaded;
+	ImportStats importStats;
+	AABB bounds;	// Object space
+
+	// GPU vertex layout, and how quantized positions map back onto the bounds above
+	VertexFormat vertexFormat;
+	PositionDequantization positionDequantization;
+	unsigned int dequantizationProgram = 0;		// Program the locations below were looked up in
+	int positionOffsetLoc = -1, positionScaleLoc = -1;
+
+	// Frustum culling over a BVH of the mesh bounds, visibility is kept until the next cull()
+	BVH bvh;
+	std::vector<AABB> meshBounds;
+	std::vector<unsigned char> meshVisible;
+	CullStats cullStats;
+	glm::mat4 cullModelMatrix = glm::mat4(1.f);
+	glm::vec4 cullNearPlane = glm::vec4(0.f);	// Object space
+
+	// Level of detail drawn for each mesh, kept until the next selectLods()
+	std::vector<unsigned char> selectedLod;
+
+	// Optional occlusion culling on top of frustum culling
+	std::unique_ptr<OcclusionQueries> occlusionQueries;
+	bool waitForOcclusion = false;
+	unsigned int VAO = 0, VBO = 0, EBO = 0;
+	unsigned int indexType = GL_UNSIGNED_INT;	// GL_UNSIGNED_SHORT if no mesh has more than MAX_SHORT_INDEX_VERTICES vertices
+	size_t indexSize = sizeof(unsigned int);
+
+	// Batched drawing, rebuilt every frame from the meshes in material order
+	std::vector<unsigned int> drawOrder;
+	std::vector<DrawElementsIndirectCommand> drawCommands;
+	std::vector<DrawBatch> drawBatches;
+	unsigned int indirectBuffer = 0;
+	bool useIndirect = false;
+
+	// Arguments for glMultiDrawElementsBaseVertex where indirect drawing isn't available (GL 3.3)
+	std::vector<GLsizei> drawCounts;
+	std::vector<const void*> drawOffsets;
+	std::vector<GLint> drawBaseVertices;
 
 	// Methods
 	void loadModel(std::string path);
-	void processNode(aiNode *node, const aiScene *scene);
-	Mesh processMesh(aiMesh *mesh, const aiScene *scene);
+	void loadPacked(const PackedModel& packed);
+	void setupBuffers(const Vertex* vertices, size_t vertexCount, const void* indices, size_t indexCount);
+	void uploadVertices(const Vertex* vertices, size_t count, size_t baseVertex);
+	void uploadIndices(const std::vector<unsigned int>& indices, size_t firstIndex);
+	void setIndexSize(size_t size);
+	void setupBatches();
+	void setupCulling();
+	void buildDrawCommands();
+	void submitDrawCommands(Shader& shader);
 	unsigned int TextureFromFile(const char* path, const std::string& directory, bool gamma = false);
-	std::vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName);
+	std::vector<Texture> loadTextures(const std::vector<TextureRef>& refs);
 };
\ No newline at end of file
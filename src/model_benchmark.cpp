@@ -0,0 +1,367 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "shader.cpp"
+#include "camera.h"
+#include "stb_image.h"
+#include "model.h"
+#include "texture_loader.h"
+#include "scene.h"
+#include "camera_path.h"
+#include "offscreen_target.h"
+#include "profiler.h"
+
+/*
+	Renders the same scene as model_loader_main along a camera path for a fixed number of frames and
+	reports how long they took:
+
+		model_benchmark [--model <file>] [--camera-path <file>] [--frames <count>] [--warmup <count>]
+		                [--size <width>x<height>] [--seed <light seed>] [--lights <count>]
+		                [--vertex-format float|quantized] [--occlusion] [--json <file>] [--csv <file>]
+		                [--profile <trace.json>]
+
+	Time advances by a fixed step per frame and lights come from a fixed seed, so two runs draw
+	exactly the same frames. Without a camera path the camera orbits the model once over the run.
+	Every frame is finished before the next one starts, so each starts on an idle GPU. With
+	--occlusion every frame uses all of the previous frame's occlusion results, so the culled meshes
+	don't depend on GPU timing either.
+
+	Every frame records the CPU time spent submitting it, the time until the GPU finished it, the GPU
+	time measured by a timer query, the draw calls, triangles and texture binds. As the frame is
+	already finished, its timer query is read right away without stalling. Warmup frames are rendered
+	but not recorded. With --profile, the scopes of every frame are timed as well and written out
+	as a Chrome trace.
+*/
+
+#ifdef PROJECT_ROOT_DIR
+
+// Constants
+const std::string MODEL_ASSET_PATH = std::string(PROJECT_ROOT_DIR) + "/assets/backpack.obj";
+const float BENCHMARK_TIME_STEP = 1.f / 60.f;
+const unsigned int ORBIT_STEPS = 64;
+
+struct BenchmarkOptions {
+	std::string modelPath = MODEL_ASSET_PATH;
+	std::string cameraPath;			// Orbit around the model if empty
+	unsigned int frameCount = 600;
+	unsigned int warmupFrames = 60;
+	int width = 1280;
+	int height = 720;
+	unsigned int lightSeed = 1;
+	unsigned int lightCount = 10;
+	VertexFormat vertexFormat = VertexFormat::Float;
+	bool occlusionCulling = false;
+	std::string jsonPath;
+	std::string csvPath;
+	std::string profilePath;
+};
+
+struct FrameSample {
+	double cpuMs = 0.0;				// Submitting the frame, from the start of the frame until the draw calls return
+	double frameMs = 0.0;			// Whole frame, until the GPU finished it
+	double gpuMs = 0.0;				// GL_TIME_ELAPSED around the frame's commands
+	unsigned int drawCalls = 0;
+	unsigned int triangles = 0;
+	unsigned int textureBinds = 0;
+	unsigned int drawnMeshes = 0;
+};
+
+struct Distribution {
+	double min = 0.0, mean = 0.0, p50 = 0.0, p90 = 0.0, p95 = 0.0, p99 = 0.0, max = 0.0;
+};
+
+bool parseArguments(int argc, char** argv, BenchmarkOptions& options);
+Distribution summarize(const std::vector<FrameSample>& samples, double FrameSample::* field);
+bool writeJson(const std::string& path, const BenchmarkOptions& options, const std::vector<FrameSample>& samples);
+bool writeCsv(const std::string& path, const std::vector<FrameSample>& samples);
+
+int main(int argc, char** argv)
+{
+	BenchmarkOptions options;
+	if (!parseArguments(argc, argv, options))
+		return EXIT_FAILURE;
+
+	// Initialize glfw, with a hidden window that only provides the context
+	if (!glfwInit())
+	{
+		std::cout << "Failed to initialize glfw.\n";
+		return EXIT_FAILURE;
+	}
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(options.width, options.height, "Model Benchmark", NULL, NULL);
+	if (window == NULL)
+	{
+		std::cout << "Failed to create glfw window.\n";
+		glfwTerminate();
+		return EXIT_FAILURE;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSwapInterval(0);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize glad\n";
+		return EXIT_FAILURE;
+	}
+
+	stbi_set_flip_vertically_on_load(true);
+	glEnable(GL_DEPTH_TEST);
+
+	OffscreenTarget target(options.width, options.height);
+	if (!target.isComplete())
+		return EXIT_FAILURE;
+
+	Scene scene(options.modelPath, options.vertexFormat, options.lightCount, options.lightSeed);
+	Model& model = scene.getModel();
+	// Occlusion results are waited for, so a run culls the same meshes every time. The previous frame
+	// was finished, so they are always ready.
+	model.setOcclusionCulling(options.occlusionCulling, true);
+	Profiler& profiler = Profiler::shared();
+	profiler.setEnabled(!options.profilePath.empty());
+
+	// Frames must not depend on how fast textures decode
+	TextureLoader::shared().finishUploads();
+
+	unsigned int totalFrames = options.warmupFrames + options.frameCount;
+	CameraPath cameraPath;
+	if (!options.cameraPath.empty())
+	{
+		if (!cameraPath.load(options.cameraPath))
+			return EXIT_FAILURE;
+	}
+	else
+	{
+		const AABB& bounds = model.getBounds();
+		glm::vec3 center = bounds.isEmpty() ? glm::vec3(0.f) : (bounds.min + bounds.max) * .5f;
+		float size = bounds.isEmpty() ? 1.f : glm::length(bounds.max - bounds.min);
+		cameraPath = CameraPath::makeOrbit(center, size, size * .25f, totalFrames * BENCHMARK_TIME_STEP, ORBIT_STEPS);
+	}
+
+	Camera camera = Camera(glm::vec3(0.f, 0.f, 3.f), glm::vec3(0.f, 0.f, -1.f), glm::vec3(0.f, 1.f, 0.f));
+	std::vector<FrameSample> samples(totalFrames);
+
+	unsigned int timerQuery;
+	glGenQueries(1, &timerQuery);
+
+	for (unsigned int frame = 0; frame < totalFrames; frame++)
+	{
+		profiler.beginFrame();
+
+		auto frameStart = std::chrono::steady_clock::now();
+		cameraPath.apply(frame * BENCHMARK_TIME_STEP, camera);
+
+		glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+		target.bind();
+		scene.render(camera, options.width, options.height);
+		glEndQuery(GL_TIME_ELAPSED);
+		auto submitEnd = std::chrono::steady_clock::now();
+
+		// Wait for the frame, so the next one starts on an idle GPU like every other run
+		glFinish();
+		auto frameEnd = std::chrono::steady_clock::now();
+
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(timerQuery, GL_QUERY_RESULT, &elapsed);
+
+		const CullStats& stats = model.getCullStats();
+		FrameSample& sample = samples[frame];
+		sample.cpuMs = std::chrono::duration<double, std::milli>(submitEnd - frameStart).count();
+		sample.frameMs = std::chrono::duration<double, std::milli>(frameEnd - frameStart).count();
+		sample.gpuMs = elapsed / 1e6;
+		sample.drawCalls = stats.drawCalls;
+		sample.triangles = stats.drawnTriangles;
+		sample.textureBinds = stats.textureBinds;
+		sample.drawnMeshes = stats.drawnMeshes;
+
+		glfwPollEvents();
+	}
+	glDeleteQueries(1, &timerQuery);
+	if (profiler.isEnabled())
+		profiler.release();
+
+	samples.erase(samples.begin(), samples.begin() + options.warmupFrames);
+
+	// Report
+	std::cout << "Rendered " << samples.size() << " frames at " << options.width << "x" << options.height << " (" << options.warmupFrames
+		<< " warmup), light seed " << options.lightSeed << "\n";
+	const std::pair<const char*, double FrameSample::*> timings[] = {
+		{ "cpu", &FrameSample::cpuMs }, { "frame", &FrameSample::frameMs }, { "gpu", &FrameSample::gpuMs }
+	};
+	for (const auto& timing : timings)
+	{
+		Distribution d = summarize(samples, timing.second);
+		std::printf("  %-6s ms  min %7.3f  mean %7.3f  p50 %7.3f  p90 %7.3f  p95 %7.3f  p99 %7.3f  max %7.3f\n",
+			timing.first, d.min, d.mean, d.p50, d.p90, d.p95, d.p99, d.max);
+	}
+
+	if (!options.profilePath.empty())
+		profiler.printStats();
+
+	bool written = true;
+	if (!options.jsonPath.empty())
+		written = writeJson(options.jsonPath, options, samples) && written;
+	if (!options.csvPath.empty())
+		written = writeCsv(options.csvPath, samples) && written;
+	if (!options.profilePath.empty())
+		written = profiler.writeChromeTrace(options.profilePath) && written;
+
+	glfwTerminate();
+	return written ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+bool parseArguments(int argc, char** argv, BenchmarkOptions& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (argument == "--occlusion")
+			options.occlusionCulling = true;
+		else if (argument == "--model" && hasValue)
+			options.modelPath = argv[++i];
+		else if (argument == "--camera-path" && hasValue)
+			options.cameraPath = argv[++i];
+		else if (argument == "--json" && hasValue)
+			options.jsonPath = argv[++i];
+		else if (argument == "--csv" && hasValue)
+			options.csvPath = argv[++i];
+		else if (argument == "--profile" && hasValue)
+			options.profilePath = argv[++i];
+		else if (argument == "--frames" && hasValue)
+			options.frameCount = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+		else if (argument == "--warmup" && hasValue)
+			options.warmupFrames = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+		else if (argument == "--seed" && hasValue)
+			options.lightSeed = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+		else if (argument == "--lights" && hasValue)
+			options.lightCount = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+		else if (argument == "--vertex-format" && hasValue && (std::strcmp(argv[i + 1], "float") == 0 || std::strcmp(argv[i + 1], "quantized") == 0))
+			options.vertexFormat = std::strcmp(argv[++i], "quantized") == 0 ? VertexFormat::Quantized : VertexFormat::Float;
+		else if (argument == "--size" && hasValue && std::sscanf(argv[i + 1], "%dx%d", &options.width, &options.height) == 2
+			&& options.width > 0 && options.height > 0)
+			i++;
+		else
+		{
+			std::cout << "Usage: model_benchmark [--model <file>] [--camera-path <file>] [--frames <count>] [--warmup <count>]\n"
+				<< "                       [--size <width>x<height>] [--seed <light seed>] [--lights <count>]\n"
+				<< "                       [--vertex-format float|quantized] [--occlusion] [--json <file>] [--csv <file>]\n"
+				<< "                       [--profile <trace.json>]\n";
+			return false;
+		}
+	}
+
+	if (options.frameCount == 0)
+	{
+		std::cout << "ERROR::BENCHMARK::--frames must be at least 1" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// Percentiles by nearest rank
+Distribution summarize(const std::vector<FrameSample>& samples, double FrameSample::* field)
+{
+	Distribution d;
+	if (samples.empty())
+		return d;
+
+	std::vector<double> values;
+	values.reserve(samples.size());
+	for (const FrameSample& sample : samples)
+		values.push_back(sample.*field);
+	std::sort(values.begin(), values.end());
+
+	auto percentile = [&](double p) {
+		size_t rank = static_cast<size_t>(std::ceil(p * values.size()));
+		return values[std::min(std::max(rank, size_t(1)), values.size()) - 1];
+	};
+	d.min = values.front();
+	d.max = values.back();
+	for (double value : values)
+		d.mean += value;
+	d.mean /= values.size();
+	d.p50 = percentile(.5);
+	d.p90 = percentile(.9);
+	d.p95 = percentile(.95);
+	d.p99 = percentile(.99);
+	return d;
+}
+
+static void writeDistribution(std::ofstream& file, const char* name, const Distribution& d, bool last)
+{
+	file << "\t\t\"" << name << "\": { \"min\": " << d.min << ", \"mean\": " << d.mean << ", \"p50\": " << d.p50 << ", \"p90\": " << d.p90
+		<< ", \"p95\": " << d.p95 << ", \"p99\": " << d.p99 << ", \"max\": " << d.max << " }" << (last ? "\n" : ",\n");
+}
+
+// Summary of the run and its settings. Paths are written as given, they are not escaped.
+bool writeJson(const std::string& path, const BenchmarkOptions& options, const std::vector<FrameSample>& samples)
+{
+	std::ofstream file(path);
+	if (!file)
+	{
+		std::cout << "ERROR::BENCHMARK::Could not write " << path << std::endl;
+		return false;
+	}
+
+	double drawCalls = 0.0, triangles = 0.0, textureBinds = 0.0;
+	for (const FrameSample& sample : samples)
+	{
+		drawCalls += sample.drawCalls;
+		triangles += sample.triangles;
+		textureBinds += sample.textureBinds;
+	}
+	double frames = std::max<double>(samples.size(), 1.0);
+
+	file << "{\n"
+		<< "\t\"model\": \"" << options.modelPath << "\",\n"
+		<< "\t\"cameraPath\": \"" << (options.cameraPath.empty() ? "orbit" : options.cameraPath) << "\",\n"
+		<< "\t\"width\": " << options.width << ",\n"
+		<< "\t\"height\": " << options.height << ",\n"
+		<< "\t\"frames\": " << samples.size() << ",\n"
+		<< "\t\"warmupFrames\": " << options.warmupFrames << ",\n"
+		<< "\t\"lightSeed\": " << options.lightSeed << ",\n"
+		<< "\t\"lights\": " << options.lightCount << ",\n"
+		<< "\t\"vertexFormat\": \"" << (options.vertexFormat == VertexFormat::Quantized ? "quantized" : "float") << "\",\n"
+		<< "\t\"occlusionCulling\": " << (options.occlusionCulling ? "true" : "false") << ",\n"
+		<< "\t\"milliseconds\": {\n";
+	writeDistribution(file, "cpu", summarize(samples, &FrameSample::cpuMs), false);
+	writeDistribution(file, "frame", summarize(samples, &FrameSample::frameMs), false);
+	writeDistribution(file, "gpu", summarize(samples, &FrameSample::gpuMs), true);
+	file << "\t},\n"
+		<< "\t\"perFrame\": { \"drawCalls\": " << drawCalls / frames << ", \"triangles\": " << triangles / frames
+		<< ", \"textureBinds\": " << textureBinds / frames << " }\n"
+		<< "}\n";
+	return static_cast<bool>(file);
+}
+
+// One row per recorded frame
+bool writeCsv(const std::string& path, const std::vector<FrameSample>& samples)
+{
+	std::ofstream file(path);
+	if (!file)
+	{
+		std::cout << "ERROR::BENCHMARK::Could not write " << path << std::endl;
+		return false;
+	}
+
+	file << "frame,cpu_ms,frame_ms,gpu_ms,draw_calls,triangles,texture_binds,drawn_meshes\n";
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		const FrameSample& s = samples[i];
+		file << i << ',' << s.cpuMs << ',' << s.frameMs << ',' << s.gpuMs << ',' << s.drawCalls << ',' << s.triangles << ','
+			<< s.textureBinds << ',' << s.drawnMeshes << '\n';
+	}
+	return static_cast<bool>(file);
+}
+
+#endif
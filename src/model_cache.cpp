@@ -0,0 +1,114 @@
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include "model_cache.h"
+
+namespace fs = std::filesystem;
+
+// FNV-1a over the whole source file
+static bool hashFile(const std::string& path, uint64_t& hash)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	hash = 14695981039346656037ull;
+	char buffer[1 << 16];
+	while (file)
+	{
+		file.read(buffer, sizeof(buffer));
+		std::streamsize count = file.gcount();
+		for (std::streamsize i = 0; i < count; i++)
+		{
+			hash ^= static_cast<unsigned char>(buffer[i]);
+			hash *= 1099511628211ull;
+		}
+	}
+	return true;
+}
+
+// Path, size and mtime of a source file, without hashing it
+static bool statSource(const std::string& path, PackedSourceFile& source)
+{
+	std::error_code error;
+	source.size = fs::file_size(path, error);
+	if (error)
+		return false;
+	source.mtime = static_cast<int64_t>(fs::last_write_time(path, error).time_since_epoch().count());
+	if (error)
+		return false;
+
+	source.path = fs::absolute(path, error).lexically_normal().generic_string();
+	if (error)
+		source.path = path;
+	return true;
+}
+
+// A cached file is unchanged if it still has the same size and either the same mtime or the same content
+static bool isUnchanged(const PackedSourceFile& cached, const std::string& path)
+{
+	PackedSourceFile current;
+	if (!statSource(path, current) || current.size != cached.size)
+		return false;
+	return current.mtime == cached.mtime || (hashFile(path, current.contentHash) && current.contentHash == cached.contentHash);
+}
+
+std::string modelCachePath(const std::string& sourcePath)
+{
+	return sourcePath + ".meshcache";
+}
+
+bool describeModelSource(const std::string& sourcePath, unsigned int importFlags, const std::vector<std::string>& dependencies, PackedSource& source)
+{
+	source.importFlags = importFlags;
+	if (!statSource(sourcePath, source) || !hashFile(sourcePath, source.contentHash))
+		return false;
+
+	source.dependencies.resize(dependencies.size());
+	for (size_t i = 0; i < dependencies.size(); i++)
+	{
+		if (!statSource(dependencies[i], source.dependencies[i]) || !hashFile(dependencies[i], source.dependencies[i].contentHash))
+			return false;
+	}
+	return true;
+}
+
+bool openModelCache(const std::string& sourcePath, unsigned int importFlags, PackedModel& model)
+{
+	PackedSource current;
+	if (!statSource(sourcePath, current) || !model.open(modelCachePath(sourcePath)))
+		return false;
+
+	// Key must match the source file as it is now. Only hash it when the mtime alone can't tell.
+	const PackedHeader& cached = model.header();
+	bool valid = cached.importFlags == importFlags && cached.sourceSize == current.size && model.sourcePath() == current.path;
+	if (valid && cached.sourceMtime != current.mtime)
+		valid = hashFile(sourcePath, current.contentHash) && cached.contentHash == current.contentHash;
+
+	// And so must every file the import read besides it, like the material libraries of an OBJ
+	if (valid)
+	{
+		for (const PackedSourceFile& dependency : model.dependencies())
+		{
+			if (!isUnchanged(dependency, dependency.path))
+			{
+				valid = false;
+				break;
+			}
+		}
+	}
+
+	if (!valid)
+		model.close();
+	return valid;
+}
+
+bool writeModelCache(const std::string& sourcePath, unsigned int importFlags, const std::vector<std::string>& dependencies, const std::vector<MeshData>& meshes,
+	const std::vector<ModelNode>& nodes)
+{
+	PackedSource source;
+	if (!describeModelSource(sourcePath, importFlags, dependencies, source))
+		return false;
+
+	return writePackedModel(modelCachePath(sourcePath), meshes, nodes, source);
+}
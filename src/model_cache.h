@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "mesh_data.h"
+#include "packed_model.h"
+
+/*
+	On-disk cache of imported models. Parsing a large OBJ through Assimp can take seconds, while the
+	flattened Vertex/index/texture records we actually need are just a few contiguous arrays. After the
+	first import we store those records as a packed model next to the source file, and on later starts
+	Model maps it instead of touching Assimp.
+
+	A cache file is only used if it was written by the same packed model version, for the same source
+	path and import flags, and the source file still has the same size and either the same mtime or the
+	same content hash (so a fresh checkout that only bumps mtimes still hits the cache). The same holds
+	for every other file the import read, such as the .mtl libraries an OBJ takes its textures from.
+*/
+
+// Path of the cache file belonging to a model source file
+std::string modelCachePath(const std::string& sourcePath);
+
+// Describe the source file and the files it references as they are now, including their content hashes
+bool describeModelSource(const std::string& sourcePath, unsigned int importFlags, const std::vector<std::string>& dependencies, PackedSource& source);
+
+// Map the cache of sourcePath into model. Returns false if there is no valid cache for it.
+bool openModelCache(const std::string& sourcePath, unsigned int importFlags, PackedModel& model);
+
+// Write meshes and their scene graph to the cache of sourcePath, keyed by it and the files it references. Returns false if the cache could not be written.
+bool writeModelCache(const std::string& sourcePath, unsigned int importFlags, const std::vector<std::string>& dependencies, const std::vector<MeshData>& meshes,
+	const std::vector<ModelNode>& nodes);
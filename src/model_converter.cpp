@@ -0,0 +1,63 @@
+#include <filesystem>
+#include <iostream>
+#include "model_import.h"
+#include "model_cache.h"
+#include "packed_model.h"
+
+namespace fs = std::filesystem;
+
+/*
+	Offline converter from any Assimp supported file to the packed model format:
+
+		model_converter <input model> [output.pmodel]
+
+	Texture paths are rewritten relative to the output file, so the packed model can live in a
+	different directory than its source.
+*/
+
+int main(int argc, char** argv)
+{
+	if (argc < 2 || argc > 3)
+	{
+		std::cout << "Usage: model_converter <input model> [output" << PACKED_MODEL_EXTENSION << "]\n";
+		return EXIT_FAILURE;
+	}
+
+	fs::path inputPath = argv[1];
+	fs::path outputPath = argc == 3 ? fs::path(argv[2]) : fs::path(inputPath).replace_extension(PACKED_MODEL_EXTENSION);
+
+	// Import
+	ImportedModel imported;
+	if (!importModel(inputPath.string(), imported))
+		return EXIT_FAILURE;
+	std::vector<MeshData>& meshData = imported.meshes;
+	const ImportStats& stats = imported.stats;
+
+	// Texture paths are relative to the model file they are referenced from
+	fs::path inputDir = fs::absolute(inputPath).parent_path();
+	fs::path outputDir = fs::absolute(outputPath).parent_path();
+	if (inputDir != outputDir)
+	{
+		for (MeshData& mesh : meshData)
+		{
+			for (TextureRef& texture : mesh.textures)
+				texture.path = fs::relative(inputDir / texture.path, outputDir).generic_string();
+		}
+	}
+
+	// Write
+	PackedSource source;
+	if (!describeModelSource(inputPath.string(), MODEL_IMPORT_FLAGS, imported.sourceFiles, source))
+	{
+		std::cout << "ERROR::MODEL_CONVERTER::Could not read " << inputPath << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (!writePackedModel(outputPath.string(), meshData, imported.nodes, source))
+		return EXIT_FAILURE;
+
+	std::cout << "Wrote " << outputPath.string() << ": " << stats.meshCount << " meshes, " << stats.vertexCount << " vertices, "
+		<< stats.indexCount << " indices\n";
+	std::cout << "Vertex cache: ACMR " << stats.cacheBefore.acmr() << " -> " << stats.cacheAfter.acmr() << ", ATVR " << stats.cacheBefore.atvr()
+		<< " -> " << stats.cacheAfter.atvr() << "\n";
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <filesystem>
+#include <assimp/DefaultIOSystem.h>
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include "allocation_counter.h"
+#include "mesh_simplifier.h"
+#include "model_import.h"
+#include "thread_pool.h"
+
+// Assimp post-processing applied on import. Also part of the mesh cache key. Triangulate leaves
+// lines and points alone, SortByPType moves them into meshes of their own, which are skipped.
+const unsigned int MODEL_IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_SortByPType | aiProcess_JoinIdenticalVertices | aiProcess_FlipUVs;
+
+namespace fs = std::filesystem;
+
+// File system of Assimp that notes every file it opens besides the model file, so the mesh cache
+// can tell when one of them changes
+class RecordingIOSystem : public Assimp::DefaultIOSystem
+{
+public:
+	RecordingIOSystem(const std::string& modelPath, std::vector<std::string>& openedFiles)
+		: modelPath(normalize(modelPath)), openedFiles(openedFiles)
+	{
+	}
+
+	using Assimp::DefaultIOSystem::Open;
+	Assimp::IOStream* Open(const char* file, const char* mode) override
+	{
+		Assimp::IOStream* stream = Assimp::DefaultIOSystem::Open(file, mode);
+		std::string path = normalize(file);
+		if (stream && path != modelPath && std::find(openedFiles.begin(), openedFiles.end(), path) == openedFiles.end())
+			openedFiles.push_back(path);
+		return stream;
+	}
+
+private:
+	std::string modelPath;
+	std::vector<std::string>& openedFiles;
+
+	static std::string normalize(const std::string& path)
+	{
+		std::error_code error;
+		fs::path absolute = fs::absolute(path, error);
+		return error ? path : absolute.lexically_normal().generic_string();
+	}
+};
+
+// Import model into Scene object and flatten its materials, meshes and scene graph
+bool importModel(const std::string& path, ImportedModel& model, bool splitLargeMeshes)
+{
+	AllocationCounter allocationCounter;
+	Assimp::Importer importer;
+	model.sourceFiles.clear();
+	importer.SetIOHandler(new RecordingIOSystem(path, model.sourceFiles));	// Owned by the importer
+	const aiScene* scene = importer.ReadFile(path, MODEL_IMPORT_FLAGS);
+	if (!scene || !scene->mRootNode || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE)
+	{
+		std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
+		return false;
+	}
+
+	std::vector<MeshData>& meshData = model.meshes;
+	std::vector<ModelNode>& nodes = model.nodes;
+
+	// Materials once each, however many meshes use them
+	model.materials.clear();
+	model.materials.reserve(scene->mNumMaterials);
+	for (unsigned int i = 0; i < scene->mNumMaterials; i++)
+		model.materials.push_back(processMaterial(scene->mMaterials[i]));
+
+	// Gather nodes and their meshes in node order, then flatten the meshes in parallel. The scene is
+	// only read from here on.
+	std::vector<aiMesh*> sceneMeshes;
+	std::vector<unsigned int> meshNodes;
+	nodes.clear();
+	processNode(scene->mRootNode, -1, scene, nodes, sceneMeshes, meshNodes);
+
+	meshData.clear();
+	meshData.resize(sceneMeshes.size());
+	std::vector<VertexCacheStats> cacheBefore(sceneMeshes.size()), cacheAfter(sceneMeshes.size());
+	ThreadPool::shared().parallelFor(sceneMeshes.size(), [&](size_t i) {
+		meshData[i] = processMesh(sceneMeshes[i], nodes[meshNodes[i]].worldTransform, cacheBefore[i], cacheAfter[i]);
+		if (meshData[i].material < model.materials.size())
+			meshData[i].textures = model.materials[meshData[i].material].textures;
+	});
+
+	// Split meshes too large for 16-bit indices. Parts stay next to each other, so every node still
+	// owns a contiguous range of meshes.
+	if (splitLargeMeshes)
+	{
+		std::vector<MeshData> splitData;
+		splitData.reserve(meshData.size());
+		std::vector<unsigned int> firstPart(meshData.size() + 1);
+		for (size_t i = 0; i < meshData.size(); i++)
+		{
+			firstPart[i] = static_cast<unsigned int>(splitData.size());
+			if (meshData[i].vertices.size() > MAX_SHORT_INDEX_VERTICES)
+				splitMesh(meshData[i], MAX_SHORT_INDEX_VERTICES, splitData);
+			else
+				splitData.push_back(std::move(meshData[i]));
+		}
+		firstPart[meshData.size()] = static_cast<unsigned int>(splitData.size());
+
+		for (ModelNode& node : nodes)
+		{
+			unsigned int end = firstPart[node.firstMesh + node.meshCount];
+			node.firstMesh = firstPart[node.firstMesh];
+			node.meshCount = end - node.firstMesh;
+		}
+		meshData.swap(splitData);
+	}
+
+	ThreadPool::shared().parallelFor(meshData.size(), [&](size_t i) {
+		generateLods(meshData[i]);
+	});
+
+	ImportStats& stats = model.stats;
+	stats = ImportStats();
+	stats.meshCount = meshData.size();
+	for (size_t i = 0; i < sceneMeshes.size(); i++)
+	{
+		stats.cacheBefore.add(cacheBefore[i]);
+		stats.cacheAfter.add(cacheAfter[i]);
+	}
+	for (const MeshData& data : meshData)
+	{
+		stats.vertexCount += data.vertices.size();
+		stats.indexCount += data.indices.size();
+		for (const LodData& lod : data.lods)
+			stats.lodIndexCount += lod.indices.size();
+	}
+
+	AllocationTotals allocated = allocationCounter.totals();
+	stats.allocations = allocated.allocations;
+	stats.bytesAllocated = allocated.bytes;
+	return true;
+}
+
+// Recursively process each node in a Scene object to record it and collect its meshes
+void processNode(aiNode* node, int parent, const aiScene* scene, std::vector<ModelNode>& nodes, std::vector<aiMesh*>& sceneMeshes,
+	std::vector<unsigned int>& meshNodes)
+{
+	// Record node. Assimp matrices are row major.
+	const aiMatrix4x4& m = node->mTransformation;
+	ModelNode record;
+	record.name = node->mName.C_Str();
+	record.parent = parent;
+	record.localTransform = glm::mat4(m.a1, m.b1, m.c1, m.d1, m.a2, m.b2, m.c2, m.d2, m.a3, m.b3, m.c3, m.d3, m.a4, m.b4, m.c4, m.d4);
+	record.worldTransform = parent >= 0 ? nodes[parent].worldTransform * record.localTransform : record.localTransform;
+	record.firstMesh = static_cast<unsigned int>(sceneMeshes.size());
+
+	unsigned int index = static_cast<unsigned int>(nodes.size());
+	nodes.push_back(record);
+
+	// Collect the triangle meshes in node, everything downstream draws and processes triangle lists.
+	// SortByPType leaves each mesh with one primitive type, but Triangulate may also set
+	// aiPrimitiveType_NGONEncodingFlag on meshes it triangulated, so only the triangle bit is tested.
+	for (unsigned int i = 0; i < node->mNumMeshes; i++)
+	{
+		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+		if (!(mesh->mPrimitiveTypes & aiPrimitiveType_TRIANGLE))
+			continue;
+		sceneMeshes.push_back(mesh);
+		meshNodes.push_back(index);
+	}
+	nodes[index].meshCount = static_cast<unsigned int>(sceneMeshes.size()) - record.firstMesh;
+
+	// Process all children of current node
+	for (unsigned int i = 0; i < node->mNumChildren; i++)
+		processNode(node->mChildren[i], static_cast<int>(index), scene, nodes, sceneMeshes, meshNodes);
+}
+
+// Bounding sphere around the box center, which is close enough to minimal for culling
+static BoundingSphere boundingSphere(const std::vector<Vertex>& vertices, const AABB& bounds)
+{
+	BoundingSphere sphere;
+	if (bounds.isEmpty())
+		return sphere;
+
+	sphere.center = bounds.center();
+	float radiusSquared = 0.f;
+	for (const Vertex& vertex : vertices)
+	{
+		glm::vec3 offset = vertex.position - sphere.center;
+		radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+	}
+	sphere.radius = std::sqrt(radiusSquared);
+	return sphere;
+}
+
+// Cut a mesh into parts of at most maxVertices vertices each, appended to parts. Triangles are
+// taken in their optimized order and vertices renumbered by first use in each part, so both
+// orders survive the split. Vertices on a cut are duplicated into every part using them.
+void splitMesh(MeshData& data, size_t maxVertices, std::vector<MeshData>& parts)
+{
+	const unsigned int unused = ~0u;
+	std::vector<unsigned int> remap(data.vertices.size(), unused);
+	std::vector<unsigned int> partVertices;
+
+	size_t triangle = 0;
+	while (triangle * 3 < data.indices.size())
+	{
+		MeshData part;
+		part.textures = data.textures;
+		part.material = data.material;
+		partVertices.clear();
+
+		for (; triangle * 3 < data.indices.size(); triangle++)
+		{
+			const unsigned int* corners = &data.indices[triangle * 3];
+			size_t newVertices = 0;
+			for (int corner = 0; corner < 3; corner++)
+			{
+				if (remap[corners[corner]] == unused && std::find(corners, corners + corner, corners[corner]) == corners + corner)
+					newVertices++;
+			}
+			if (partVertices.size() + newVertices > maxVertices)
+				break;
+
+			for (int corner = 0; corner < 3; corner++)
+			{
+				unsigned int vertex = corners[corner];
+				if (remap[vertex] == unused)
+				{
+					remap[vertex] = static_cast<unsigned int>(partVertices.size());
+					partVertices.push_back(vertex);
+					part.vertices.push_back(data.vertices[vertex]);
+					part.bounds.grow(data.vertices[vertex].position);
+				}
+				part.indices.push_back(remap[vertex]);
+			}
+		}
+
+		for (unsigned int vertex : partVertices)
+			remap[vertex] = unused;
+		part.sphere = boundingSphere(part.vertices, part.bounds);
+		parts.push_back(std::move(part));
+	}
+}
+
+// Flatten the vertices and indices of an aiMesh from a Scene object.
+// Vertices are moved into model space by the world transform of the node the mesh belongs to, so
+// every mesh can still be drawn with the one model matrix. Triangles and vertices are then
+// reordered for the GPU's vertex cache, overdraw and vertex fetch.
+MeshData processMesh(aiMesh* mesh, const glm::mat4& transform, VertexCacheStats& cacheBefore, VertexCacheStats& cacheAfter)
+{
+	MeshData data;
+	glm::mat3 normalTransform = glm::transpose(glm::inverse(glm::mat3(transform)));
+
+	// Process vertices. Storage is reserved up front, so each vertex is written exactly once, into
+	// its final slot.
+	const aiVector3D* positions = mesh->mVertices;
+	const aiVector3D* normals = mesh->mNormals;
+	const aiVector3D* texCoords = mesh->mTextureCoords[0];
+
+	data.vertices.reserve(mesh->mNumVertices);
+	for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+	{
+		glm::vec3 normal = normals ? glm::vec3(normals[i].x, normals[i].y, normals[i].z) : glm::vec3(0.f);
+		data.vertices.push_back(Vertex{
+			glm::vec3(transform * glm::vec4(positions[i].x, positions[i].y, positions[i].z, 1.f)),
+			normals ? glm::normalize(normalTransform * normal) : normal,
+			texCoords ? glm::vec2(texCoords[i].x, texCoords[i].y) : glm::vec2(0.f, 0.f)
+		});
+		data.bounds.grow(data.vertices.back().position);
+	}
+
+	data.sphere = boundingSphere(data.vertices, data.bounds);
+
+	// Process indices. Only triangle meshes get here, so this reserve is exact. Any other face is
+	// still skipped, as the optimizer, splitMesh and the simplifier all read indices in threes.
+	data.indices.reserve(static_cast<size_t>(mesh->mNumFaces) * 3);
+	for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+	{
+		const aiFace& face = mesh->mFaces[i];
+		if (face.mNumIndices == 3)
+			data.indices.insert(data.indices.end(), face.mIndices, face.mIndices + 3);
+	}
+
+	// Reorder for the GPU
+	cacheBefore = analyzeVertexCache(data.indices, data.vertices.size());
+	optimizeMesh(data);
+	cacheAfter = analyzeVertexCache(data.indices, data.vertices.size());
+
+	// The material's textures are filled in by the caller, which has the materials
+	data.material = mesh->mMaterialIndex;
+
+	return data;
+}
+
+
+// Texture references of a material, diffuse maps first, then specular maps
+MaterialData processMaterial(aiMaterial* material)
+{
+	MaterialData data;
+	data.name = material->GetName().C_Str();
+	data.textures = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
+
+	std::vector<TextureRef> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
+	data.textures.insert(data.textures.end(), std::make_move_iterator(specularMaps.begin()), std::make_move_iterator(specularMaps.end()));
+	return data;
+}
+
+// Get list of texture references of one type from a material
+std::vector<TextureRef> loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName)
+{
+	std::vector<TextureRef> textures;
+	for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
+	{
+		// Get texture file location
+		aiString str;
+		mat->GetTexture(type, i, &str);
+		textures.push_back(TextureRef{ typeName, str.C_Str() });
+	}
+	return textures;
+}
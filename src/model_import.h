@@ -0,0 +1,55 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <assimp/scene.h>
+#include "mesh_data.h"
+#include "mesh_optimizer.h"
+
+/*
+	CPU stage of loading a model: reads a file through Assimp and flattens it into MeshData,
+	MaterialData and ModelNode records, without touching GL. Meshes are moved into model space,
+	reordered for the GPU, split for 16-bit indices and given their LODs on the way.
+
+	The result can be cached, packed or uploaded by a Model on the GL thread, and the import runs
+	just as well on machines without a GPU. The stages are exposed on their own so they can be
+	timed and tested separately.
+*/
+
+// Assimp post-processing applied on import. Also part of the mesh cache key.
+extern const unsigned int MODEL_IMPORT_FLAGS;
+
+// Counters of a single Assimp import, so allocation regressions in the import path show up in numbers.
+// Allocations stay zero unless the program links allocation_hook.cpp.
+struct ImportStats {
+	size_t meshCount = 0;
+	size_t vertexCount = 0;
+	size_t indexCount = 0;
+	size_t lodIndexCount = 0;	// Indices of the simplified LODs, on top of indexCount
+	size_t allocations = 0;		// Heap allocations made during the import, Assimp and temporaries included.
+	size_t bytesAllocated = 0;	// Heap bytes of those allocations
+
+	// Vertex cache efficiency of the full resolution meshes, in file order and after optimization
+	VertexCacheStats cacheBefore;
+	VertexCacheStats cacheAfter;
+};
+
+// Everything an import produces
+struct ImportedModel {
+	std::vector<MeshData> meshes;
+	std::vector<MaterialData> materials;
+	std::vector<ModelNode> nodes;
+	std::vector<std::string> sourceFiles;	// Files read besides the model file itself, like OBJ material libraries
+	ImportStats stats;
+};
+
+// Import a model file. Meshes with more than MAX_SHORT_INDEX_VERTICES vertices are split up, unless
+// disabled, so the whole model can be drawn with 16-bit indices.
+bool importModel(const std::string& path, ImportedModel& model, bool splitLargeMeshes = true);
+
+// Stages of importModel
+void processNode(aiNode* node, int parent, const aiScene* scene, std::vector<ModelNode>& nodes, std::vector<aiMesh*>& sceneMeshes,
+	std::vector<unsigned int>& meshNodes);
+MeshData processMesh(aiMesh* mesh, const glm::mat4& transform, VertexCacheStats& cacheBefore, VertexCacheStats& cacheAfter);
+void splitMesh(MeshData& data, size_t maxVertices, std::vector<MeshData>& parts);
+MaterialData processMaterial(aiMaterial* material);
+std::vector<TextureRef> loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName);
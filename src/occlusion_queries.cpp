@@ -0,0 +1,213 @@
+#include <algorithm>
+#include <iostream>
+#include "occlusion_queries.h"
+#include "uniform_buffers.h"
+
+// Boxes are grown by this fraction of their largest extent, plus an absolute minimum, before they
+// are tested
+const float BOX_PADDING = .01f;
+const float MIN_BOX_PADDING = 1e-4f;
+
+// Box proxy shaders. They are tiny and internal to the query pass, so they live here instead of in assets.
+static const char* BOX_VERTEX_SHADER = R"(#version 330 core
+layout (location = 0) in vec3 aPos;
+
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
+uniform mat4 model;
+uniform vec3 boxCenter;
+uniform vec3 boxExtent;
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(boxCenter + aPos * boxExtent, 1.0);
+}
+)";
+
+static const char* BOX_FRAGMENT_SHADER = R"(#version 330 core
+out vec4 FragColor;
+
+void main()
+{
+    FragColor = vec4(1.0);
+}
+)";
+
+OcclusionQueries::OcclusionQueries()
+{
+	setupProgram();
+	setupBox();
+}
+
+OcclusionQueries::~OcclusionQueries()
+{
+	if (!queries.empty())
+		glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+	glDeleteBuffers(1, &boxVBO);
+	glDeleteBuffers(1, &boxEBO);
+	glDeleteVertexArrays(1, &boxVAO);
+	glDeleteProgram(program);
+}
+
+// One query per mesh. Every mesh starts out visible.
+void OcclusionQueries::resize(size_t meshCount)
+{
+	if (!queries.empty())
+		glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+
+	queries.assign(meshCount, 0);
+	if (meshCount > 0)
+		glGenQueries(static_cast<GLsizei>(meshCount), queries.data());
+	pending.assign(meshCount, 0);
+	visible.assign(meshCount, 1);
+}
+
+// Read back the queries that have finished, or all of them if wait is set
+void OcclusionQueries::collectResults(bool wait)
+{
+	for (size_t i = 0; i < queries.size(); i++)
+	{
+		if (!pending[i])
+			continue;
+
+		if (!wait)
+		{
+			unsigned int available = 0;
+			glGetQueryObjectuiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				continue;
+		}
+
+		unsigned int samples = 0;
+		glGetQueryObjectuiv(queries[i], GL_QUERY_RESULT, &samples);
+		visible[i] = samples != 0;
+		pending[i] = 0;
+	}
+}
+
+// Rasterize the box of every frustum visible mesh without a query in flight against the current
+// depth buffer. Boxes crossing the near plane would be clipped and could report nothing even though
+// the camera is inside them, so those meshes are visible without a query.
+//
+// The depth buffer already holds the meshes themselves, and a flat or axis aligned mesh (a wall, a
+// floor, a cap) has box faces lying exactly on its own surface. Boxes are therefore padded, so no
+// face is flat, and tested with GL_LEQUAL, so a mesh can never occlude itself.
+void OcclusionQueries::issue(const std::vector<AABB>& meshBounds, const unsigned char* frustumVisible, const glm::mat4& modelMatrix, const glm::vec4& nearPlane)
+{
+	queriesIssued = 0;
+
+	glUseProgram(program);
+	glUniformMatrix4fv(modelLocation, 1, GL_FALSE, &modelMatrix[0][0]);
+	glBindVertexArray(boxVAO);
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_FALSE);
+	glDepthFunc(GL_LEQUAL);
+
+	glm::vec3 nearNormal = glm::vec3(nearPlane);
+	for (size_t i = 0; i < queries.size(); i++)
+	{
+		if (!frustumVisible[i] || pending[i] || meshBounds[i].isEmpty())
+			continue;
+
+		glm::vec3 center = meshBounds[i].center();
+		glm::vec3 extent = meshBounds[i].extents();
+		extent += glm::vec3(std::max(std::max(extent.x, std::max(extent.y, extent.z)) * BOX_PADDING, MIN_BOX_PADDING));
+		if (glm::dot(nearNormal, center) + nearPlane.w - glm::dot(glm::abs(nearNormal), extent) < 0.f)
+		{
+			visible[i] = 1;
+			continue;
+		}
+
+		glUniform3f(centerLocation, center.x, center.y, center.z);
+		glUniform3f(extentLocation, extent.x, extent.y, extent.z);
+		glBeginQuery(GL_ANY_SAMPLES_PASSED, queries[i]);
+		glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+		glEndQuery(GL_ANY_SAMPLES_PASSED);
+		pending[i] = 1;
+		queriesIssued++;
+	}
+
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+	glBindVertexArray(0);
+}
+
+void OcclusionQueries::setupProgram()
+{
+	auto compile = [](GLenum type, const char* source) {
+		unsigned int shader = glCreateShader(type);
+		glShaderSource(shader, 1, &source, NULL);
+		glCompileShader(shader);
+
+		int success;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (!success)
+		{
+			char infoLog[1024];
+			glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+			std::cout << "ERROR::OCCLUSION_QUERIES::SHADER_COMPILATION_ERROR\n" << infoLog << std::endl;
+		}
+		return shader;
+	};
+
+	unsigned int vertex = compile(GL_VERTEX_SHADER, BOX_VERTEX_SHADER);
+	unsigned int fragment = compile(GL_FRAGMENT_SHADER, BOX_FRAGMENT_SHADER);
+	program = glCreateProgram();
+	glAttachShader(program, vertex);
+	glAttachShader(program, fragment);
+	glLinkProgram(program);
+	glDeleteShader(vertex);
+	glDeleteShader(fragment);
+
+	int success;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		char infoLog[1024];
+		glGetProgramInfoLog(program, 1024, NULL, infoLog);
+		std::cout << "ERROR::OCCLUSION_QUERIES::PROGRAM_LINKING_ERROR\n" << infoLog << std::endl;
+	}
+
+	unsigned int cameraBlock = glGetUniformBlockIndex(program, "Camera");
+	if (cameraBlock != GL_INVALID_INDEX)
+		glUniformBlockBinding(program, cameraBlock, CAMERA_BLOCK_BINDING);
+	modelLocation = glGetUniformLocation(program, "model");
+	centerLocation = glGetUniformLocation(program, "boxCenter");
+	extentLocation = glGetUniformLocation(program, "boxExtent");
+}
+
+// Unit cube from -1 to 1, scaled and moved onto each mesh box by the vertex shader
+void OcclusionQueries::setupBox()
+{
+	const float corners[] = {
+		-1.f, -1.f, -1.f,   1.f, -1.f, -1.f,   1.f, 1.f, -1.f,   -1.f, 1.f, -1.f,
+		-1.f, -1.f,  1.f,   1.f, -1.f,  1.f,   1.f, 1.f,  1.f,   -1.f, 1.f,  1.f
+	};
+	const unsigned int faces[] = {
+		0, 2, 1, 0, 3, 2,	// -z
+		4, 5, 6, 4, 6, 7,	// +z
+		0, 1, 5, 0, 5, 4,	// -y
+		3, 7, 6, 3, 6, 2,	// +y
+		0, 4, 7, 0, 7, 3,	// -x
+		1, 2, 6, 1, 6, 5	// +x
+	};
+
+	glGenVertexArrays(1, &boxVAO);
+	glGenBuffers(1, &boxVBO);
+	glGenBuffers(1, &boxEBO);
+
+	glBindVertexArray(boxVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, boxVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, boxEBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(faces), faces, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+	glBindVertexArray(0);
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "bounds.h"
+
+/*
+	Hardware occlusion culling with temporal coherence. After a frame's geometry is drawn, the
+	bounding box of every mesh that passed frustum culling is rasterized against the depth buffer,
+	with color and depth writes off, inside an occlusion query. The results are read back on a later
+	frame, and meshes whose box produced no samples are skipped by the draw.
+
+	Reading a result right after issuing its query would stall until the GPU catches up, so by
+	default results are only collected once available, and a mesh keeps its last visibility until
+	then. Hidden meshes that come into view therefore show up a frame or two late. Waiting for the
+	results instead makes the outcome independent of GPU timing, for deterministic runs on software
+	GL.
+
+	The boxes read the camera from the shared Camera uniform block.
+*/
+class OcclusionQueries
+{
+public:
+	// Constructor
+	OcclusionQueries();
+	~OcclusionQueries();
+	OcclusionQueries(const OcclusionQueries&) = delete;
+	OcclusionQueries& operator=(const OcclusionQueries&) = delete;
+
+	// Methods
+	void resize(size_t meshCount);
+	void collectResults(bool wait);
+	void issue(const std::vector<AABB>& meshBounds, const unsigned char* frustumVisible, const glm::mat4& modelMatrix, const glm::vec4& nearPlane);
+	bool isVisible(unsigned int mesh) const { return visible[mesh] != 0; }
+	unsigned int getQueriesIssued() const { return queriesIssued; }
+
+private:
+	std::vector<unsigned int> queries;
+	std::vector<unsigned char> pending;
+	std::vector<unsigned char> visible;
+	unsigned int queriesIssued = 0;
+
+	unsigned int program = 0;
+	unsigned int boxVAO = 0, boxVBO = 0, boxEBO = 0;
+	int modelLocation = -1, centerLocation = -1, extentLocation = -1;
+
+	void setupProgram();
+	void setupBox();
+};
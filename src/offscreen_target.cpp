@@ -0,0 +1,74 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <glad/glad.h>
+#include "offscreen_target.h"
+
+OffscreenTarget::OffscreenTarget(int width, int height)
+	: width(width), height(height)
+{
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+	glGenRenderbuffers(1, &colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+
+	glGenRenderbuffers(1, &depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+	complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	if (!complete)
+		std::cout << "ERROR::OFFSCREEN_TARGET::Framebuffer is not complete" << std::endl;
+
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+OffscreenTarget::~OffscreenTarget()
+{
+	glDeleteRenderbuffers(1, &colorBuffer);
+	glDeleteRenderbuffers(1, &depthBuffer);
+	glDeleteFramebuffers(1, &framebuffer);
+}
+
+// Render into this target, over all of it
+void OffscreenTarget::bind() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, width, height);
+}
+
+// Current color contents as tightly packed RGB rows, top row first. Waits for rendering to finish.
+void OffscreenTarget::readPixels(std::vector<unsigned char>& rgb) const
+{
+	std::vector<unsigned char> flipped(static_cast<size_t>(width) * height * 3);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, flipped.data());
+
+	// GL returns the bottom row first
+	size_t rowSize = static_cast<size_t>(width) * 3;
+	rgb.resize(flipped.size());
+	for (int row = 0; row < height; row++)
+		std::copy_n(flipped.begin() + (height - 1 - row) * rowSize, rowSize, rgb.begin() + row * rowSize);
+}
+
+bool OffscreenTarget::writePPM(const std::string& path) const
+{
+	std::vector<unsigned char> rgb;
+	readPixels(rgb);
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file << "P6\n" << width << " " << height << "\n255\n";
+	file.write(reinterpret_cast<const char*>(rgb.data()), rgb.size());
+	if (!file)
+	{
+		std::cout << "ERROR::OFFSCREEN_TARGET::Could not write " << path << std::endl;
+		return false;
+	}
+	return true;
+}
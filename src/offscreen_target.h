@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/*
+	Framebuffer object with a color and a depth/stencil renderbuffer, to render into without a
+	visible window. Frames can be read back and written out as binary PPM images, which need no
+	image library and open in most viewers.
+*/
+class OffscreenTarget
+{
+public:
+	// Constructor
+	OffscreenTarget(int width, int height);
+	~OffscreenTarget();
+	OffscreenTarget(const OffscreenTarget&) = delete;
+	OffscreenTarget& operator=(const OffscreenTarget&) = delete;
+
+	// Methods
+	bool isComplete() const { return complete; }
+	void bind() const;
+	void readPixels(std::vector<unsigned char>& rgb) const;
+	bool writePPM(const std::string& path) const;
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+
+private:
+	int width, height;
+	unsigned int framebuffer = 0;
+	unsigned int colorBuffer = 0;
+	unsigned int depthBuffer = 0;
+	bool complete = false;
+};
@@ -0,0 +1,371 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include "packed_model.h"
+
+namespace fs = std::filesystem;
+
+const char PACKED_MODEL_MAGIC[8] = { 'M', 'L', 'P', 'A', 'C', 'K', '\0', '\0' };
+
+static_assert(sizeof(PackedHeader) == 160, "PackedHeader layout must not depend on the compiler");
+static_assert(sizeof(PackedMesh) == (17 + 3 * (MAX_MESH_LODS - 1)) * sizeof(uint32_t), "PackedMesh must stay tightly packed");
+static_assert(sizeof(PackedNode) == 22 * sizeof(uint32_t), "PackedNode must stay tightly packed");
+static_assert(sizeof(PackedTexture) == 4 * sizeof(uint32_t), "PackedTexture must stay tightly packed");
+static_assert(sizeof(PackedDependency) == 8 * sizeof(uint32_t), "PackedDependency must stay tightly packed");
+static_assert(sizeof(Vertex) == 8 * sizeof(float), "Vertex must stay tightly packed to be stored as raw bytes");
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+bool isPackedModelPath(const std::string& path)
+{
+	return fs::path(path).extension() == PACKED_MODEL_EXTENSION;
+}
+
+// Open and validate a packed model
+bool PackedModel::open(const std::string& path)
+{
+	if (!file.open(path))
+		return false;
+
+	if (!validate())
+	{
+		std::cout << "ERROR::PACKED_MODEL::Invalid or outdated packed model: " << path << std::endl;
+		file.close();
+		return false;
+	}
+	return true;
+}
+
+// Unmap the file. Pointers returned earlier become invalid.
+void PackedModel::close()
+{
+	file.close();
+}
+
+const PackedHeader& PackedModel::header() const
+{
+	return *reinterpret_cast<const PackedHeader*>(file.data());
+}
+
+const PackedMesh* PackedModel::meshes() const
+{
+	return reinterpret_cast<const PackedMesh*>(file.data() + header().meshTableOffset);
+}
+
+const Vertex* PackedModel::vertices() const
+{
+	return reinterpret_cast<const Vertex*>(file.data() + header().vertexOffset);
+}
+
+const void* PackedModel::indices() const
+{
+	return file.data() + header().indexOffset;
+}
+
+// Material table entries of a mesh
+std::vector<TextureRef> PackedModel::textures(const PackedMesh& mesh) const
+{
+	const PackedTexture* table = reinterpret_cast<const PackedTexture*>(file.data() + header().textureTableOffset);
+
+	std::vector<TextureRef> refs;
+	for (uint32_t i = 0; i < mesh.textureCount; i++)
+	{
+		const PackedTexture& texture = table[mesh.firstTexture + i];
+		refs.push_back(TextureRef{ string(texture.typeOffset, texture.typeLength), string(texture.pathOffset, texture.pathLength) });
+	}
+	return refs;
+}
+
+// Scene graph, with world transforms rebuilt from the stored local ones
+std::vector<ModelNode> PackedModel::nodes() const
+{
+	const PackedNode* table = reinterpret_cast<const PackedNode*>(file.data() + header().nodeTableOffset);
+
+	std::vector<ModelNode> result(header().nodeCount);
+	for (uint32_t i = 0; i < header().nodeCount; i++)
+	{
+		const PackedNode& packed = table[i];
+		ModelNode& node = result[i];
+		node.name = string(packed.nameOffset, packed.nameLength);
+		node.parent = packed.parent;
+		for (int column = 0; column < 4; column++)
+			node.localTransform[column] = glm::vec4(packed.localTransform[column * 4], packed.localTransform[column * 4 + 1],
+				packed.localTransform[column * 4 + 2], packed.localTransform[column * 4 + 3]);
+		node.worldTransform = node.parent >= 0 ? result[node.parent].worldTransform * node.localTransform : node.localTransform;
+		node.firstMesh = packed.firstMesh;
+		node.meshCount = packed.meshCount;
+	}
+	return result;
+}
+
+std::string PackedModel::sourcePath() const
+{
+	return string(header().sourcePathOffset, header().sourcePathLength);
+}
+
+std::vector<PackedSourceFile> PackedModel::dependencies() const
+{
+	const PackedDependency* table = reinterpret_cast<const PackedDependency*>(file.data() + header().dependencyTableOffset);
+
+	std::vector<PackedSourceFile> result(header().dependencyCount);
+	for (uint32_t i = 0; i < header().dependencyCount; i++)
+	{
+		result[i].path = string(table[i].pathOffset, table[i].pathLength);
+		result[i].size = table[i].size;
+		result[i].mtime = table[i].mtime;
+		result[i].contentHash = table[i].contentHash;
+	}
+	return result;
+}
+
+std::string PackedModel::string(uint64_t offset, uint32_t length) const
+{
+	return std::string(file.data() + header().stringOffset + offset, length);
+}
+
+// Check every offset and range so a truncated or foreign file can never be read out of bounds
+bool PackedModel::validate() const
+{
+	if (file.size() < sizeof(PackedHeader))
+		return false;
+
+	const PackedHeader& h = header();
+	if (std::memcmp(h.magic, PACKED_MODEL_MAGIC, sizeof(h.magic)) != 0 || h.version != PACKED_MODEL_VERSION || h.vertexSize != sizeof(Vertex)
+		|| (h.indexSize != sizeof(uint16_t) && h.indexSize != sizeof(uint32_t)))
+		return false;
+
+	auto fits = [&](uint64_t offset, uint64_t count, uint64_t size) {
+		return offset <= file.size() && count <= (file.size() - offset) / size;
+	};
+	if (!fits(h.meshTableOffset, h.meshCount, sizeof(PackedMesh)) || !fits(h.nodeTableOffset, h.nodeCount, sizeof(PackedNode))
+		|| !fits(h.textureTableOffset, h.textureCount, sizeof(PackedTexture)) || !fits(h.dependencyTableOffset, h.dependencyCount, sizeof(PackedDependency))
+		|| !fits(h.stringOffset, h.stringSize, 1) || !fits(h.vertexOffset, h.vertexCount, sizeof(Vertex)) || !fits(h.indexOffset, h.indexCount, h.indexSize))
+		return false;
+	if (h.meshTableOffset % alignof(PackedMesh) != 0 || h.nodeTableOffset % alignof(PackedNode) != 0 || h.textureTableOffset % alignof(PackedTexture) != 0
+		|| h.dependencyTableOffset % alignof(PackedDependency) != 0 || h.vertexOffset % PACKED_MODEL_ALIGNMENT != 0 || h.indexOffset % PACKED_MODEL_ALIGNMENT != 0)
+		return false;
+	if (uint64_t(h.sourcePathOffset) + h.sourcePathLength > h.stringSize)
+		return false;
+
+	const PackedMesh* table = meshes();
+	for (uint32_t i = 0; i < h.meshCount; i++)
+	{
+		const PackedMesh& mesh = table[i];
+		if (uint64_t(mesh.firstVertex) + mesh.vertexCount > h.vertexCount || uint64_t(mesh.firstIndex) + mesh.indexCount > h.indexCount
+			|| uint64_t(mesh.firstTexture) + mesh.textureCount > h.textureCount || mesh.lodCount < 1 || mesh.lodCount > MAX_MESH_LODS
+			|| (h.indexSize == sizeof(uint16_t) && mesh.vertexCount > MAX_SHORT_INDEX_VERTICES))
+			return false;
+		for (uint32_t lod = 0; lod + 1 < mesh.lodCount; lod++)
+		{
+			if (uint64_t(mesh.lodFirstIndex[lod]) + mesh.lodIndexCount[lod] > h.indexCount)
+				return false;
+		}
+	}
+
+	// Parents must come before their children so world transforms can be rebuilt in one pass
+	const PackedNode* nodes = reinterpret_cast<const PackedNode*>(file.data() + h.nodeTableOffset);
+	for (uint32_t i = 0; i < h.nodeCount; i++)
+	{
+		if (nodes[i].parent >= static_cast<int32_t>(i) || nodes[i].parent < -1 || uint64_t(nodes[i].firstMesh) + nodes[i].meshCount > h.meshCount
+			|| uint64_t(nodes[i].nameOffset) + nodes[i].nameLength > h.stringSize)
+			return false;
+	}
+
+	const PackedTexture* textures = reinterpret_cast<const PackedTexture*>(file.data() + h.textureTableOffset);
+	for (uint32_t i = 0; i < h.textureCount; i++)
+	{
+		if (uint64_t(textures[i].typeOffset) + textures[i].typeLength > h.stringSize || uint64_t(textures[i].pathOffset) + textures[i].pathLength > h.stringSize)
+			return false;
+	}
+
+	const PackedDependency* dependencies = reinterpret_cast<const PackedDependency*>(file.data() + h.dependencyTableOffset);
+	for (uint32_t i = 0; i < h.dependencyCount; i++)
+	{
+		if (uint64_t(dependencies[i].pathOffset) + dependencies[i].pathLength > h.stringSize)
+			return false;
+	}
+	return true;
+}
+
+// Write meshes and their scene graph as a packed model
+bool writePackedModel(const std::string& path, const std::vector<MeshData>& meshes, const std::vector<ModelNode>& nodes, const PackedSource& source)
+{
+	std::vector<PackedMesh> meshTable;
+	std::vector<PackedNode> nodeTable;
+	std::vector<PackedTexture> textureTable;
+	std::vector<PackedDependency> dependencyTable;
+	std::string strings = source.path;
+
+	PackedHeader header = {};
+	std::memcpy(header.magic, PACKED_MODEL_MAGIC, sizeof(header.magic));
+	header.version = PACKED_MODEL_VERSION;
+	header.vertexSize = sizeof(Vertex);
+	header.importFlags = source.importFlags;
+	header.sourcePathOffset = 0;
+	header.sourcePathLength = static_cast<uint32_t>(source.path.size());
+	header.sourceSize = source.size;
+	header.sourceMtime = source.mtime;
+	header.contentHash = source.contentHash;
+
+	// 16-bit indices if every mesh allows them
+	header.indexSize = sizeof(uint16_t);
+	for (const MeshData& mesh : meshes)
+	{
+		if (mesh.vertices.size() > MAX_SHORT_INDEX_VERTICES)
+			header.indexSize = sizeof(uint32_t);
+	}
+
+	// Mesh and material tables
+	for (const MeshData& mesh : meshes)
+	{
+		PackedMesh packed = {};
+		packed.firstVertex = static_cast<uint32_t>(header.vertexCount);
+		packed.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+		packed.firstIndex = static_cast<uint32_t>(header.indexCount);
+		packed.indexCount = static_cast<uint32_t>(mesh.indices.size());
+		packed.firstTexture = static_cast<uint32_t>(textureTable.size());
+		packed.textureCount = static_cast<uint32_t>(mesh.textures.size());
+		for (int axis = 0; axis < 3; axis++)
+		{
+			packed.boundsMin[axis] = mesh.bounds.min[axis];
+			packed.boundsMax[axis] = mesh.bounds.max[axis];
+			packed.sphereCenter[axis] = mesh.sphere.center[axis];
+		}
+		packed.sphereRadius = mesh.sphere.radius;
+		header.indexCount += mesh.indices.size();
+
+		// LODs follow the full resolution indices
+		packed.lodCount = 1;
+		for (size_t lod = 0; lod < mesh.lods.size() && lod + 1 < MAX_MESH_LODS; lod++)
+		{
+			packed.lodFirstIndex[lod] = static_cast<uint32_t>(header.indexCount);
+			packed.lodIndexCount[lod] = static_cast<uint32_t>(mesh.lods[lod].indices.size());
+			packed.lodError[lod] = mesh.lods[lod].error;
+			packed.lodCount++;
+			header.indexCount += mesh.lods[lod].indices.size();
+		}
+		meshTable.push_back(packed);
+
+		for (const TextureRef& texture : mesh.textures)
+		{
+			PackedTexture entry;
+			entry.typeOffset = static_cast<uint32_t>(strings.size());
+			entry.typeLength = static_cast<uint32_t>(texture.type.size());
+			strings += texture.type;
+			entry.pathOffset = static_cast<uint32_t>(strings.size());
+			entry.pathLength = static_cast<uint32_t>(texture.path.size());
+			strings += texture.path;
+			textureTable.push_back(entry);
+		}
+
+		header.vertexCount += mesh.vertices.size();
+	}
+	header.meshCount = static_cast<uint32_t>(meshTable.size());
+	header.textureCount = static_cast<uint32_t>(textureTable.size());
+
+	// Scene graph
+	for (const ModelNode& node : nodes)
+	{
+		PackedNode packed = {};
+		packed.parent = node.parent;
+		packed.firstMesh = node.firstMesh;
+		packed.meshCount = node.meshCount;
+		packed.nameOffset = static_cast<uint32_t>(strings.size());
+		packed.nameLength = static_cast<uint32_t>(node.name.size());
+		strings += node.name;
+		for (int column = 0; column < 4; column++)
+			for (int row = 0; row < 4; row++)
+				packed.localTransform[column * 4 + row] = node.localTransform[column][row];
+		nodeTable.push_back(packed);
+	}
+	header.nodeCount = static_cast<uint32_t>(nodeTable.size());
+
+	// Files referenced by the source
+	for (const PackedSourceFile& dependency : source.dependencies)
+	{
+		PackedDependency packed = {};
+		packed.pathOffset = static_cast<uint32_t>(strings.size());
+		packed.pathLength = static_cast<uint32_t>(dependency.path.size());
+		packed.size = dependency.size;
+		packed.mtime = dependency.mtime;
+		packed.contentHash = dependency.contentHash;
+		strings += dependency.path;
+		dependencyTable.push_back(packed);
+	}
+	header.dependencyCount = static_cast<uint32_t>(dependencyTable.size());
+
+	// Section layout
+	header.meshTableOffset = sizeof(PackedHeader);
+	header.nodeTableOffset = header.meshTableOffset + meshTable.size() * sizeof(PackedMesh);
+	header.textureTableOffset = header.nodeTableOffset + nodeTable.size() * sizeof(PackedNode);
+	header.dependencyTableOffset = header.textureTableOffset + textureTable.size() * sizeof(PackedTexture);
+	header.stringOffset = header.dependencyTableOffset + dependencyTable.size() * sizeof(PackedDependency);
+	header.stringSize = strings.size();
+	header.vertexOffset = alignUp(header.stringOffset + header.stringSize, PACKED_MODEL_ALIGNMENT);
+	header.indexOffset = alignUp(header.vertexOffset + header.vertexCount * sizeof(Vertex), PACKED_MODEL_ALIGNMENT);
+
+	auto writeIndices = [&](std::ofstream& file, const std::vector<unsigned int>& indices) {
+		if (header.indexSize == sizeof(uint32_t))
+		{
+			file.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(uint32_t));
+			return;
+		}
+		std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+		file.write(reinterpret_cast<const char*>(shortIndices.data()), shortIndices.size() * sizeof(uint16_t));
+	};
+
+	// Write to a temporary file first so a crash never leaves a half-written model behind
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			std::cout << "ERROR::PACKED_MODEL::Could not write file: " << tempPath << std::endl;
+			return false;
+		}
+
+		auto pad = [&](uint64_t offset) {
+			static const char zeros[PACKED_MODEL_ALIGNMENT] = {};
+			file.write(zeros, offset - static_cast<uint64_t>(file.tellp()));
+		};
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(meshTable.data()), meshTable.size() * sizeof(PackedMesh));
+		file.write(reinterpret_cast<const char*>(nodeTable.data()), nodeTable.size() * sizeof(PackedNode));
+		file.write(reinterpret_cast<const char*>(textureTable.data()), textureTable.size() * sizeof(PackedTexture));
+		file.write(reinterpret_cast<const char*>(dependencyTable.data()), dependencyTable.size() * sizeof(PackedDependency));
+		file.write(strings.data(), strings.size());
+
+		pad(header.vertexOffset);
+		for (const MeshData& mesh : meshes)
+			file.write(reinterpret_cast<const char*>(mesh.vertices.data()), mesh.vertices.size() * sizeof(Vertex));
+
+		pad(header.indexOffset);
+		for (const MeshData& mesh : meshes)
+		{
+			writeIndices(file, mesh.indices);
+			for (size_t lod = 0; lod < mesh.lods.size() && lod + 1 < MAX_MESH_LODS; lod++)
+				writeIndices(file, mesh.lods[lod].indices);
+		}
+
+		if (!file)
+		{
+			std::cout << "ERROR::PACKED_MODEL::Failed writing file: " << tempPath << std::endl;
+			return false;
+		}
+	}
+
+	std::error_code error;
+	fs::rename(tempPath, path, error);
+	if (error)
+	{
+		std::cout << "ERROR::PACKED_MODEL::Could not replace file: " << path << std::endl;
+		fs::remove(tempPath, error);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mesh_data.h"
+#include "mapped_file.h"
+
+/*
+	Native packed model format (*.pmodel). Everything Model needs is laid out so it can be memory
+	mapped and handed straight to glBufferData:
+
+		PackedHeader
+		PackedMesh[meshCount]          (per mesh ranges into the blobs below, bounds, and LOD ranges)
+		PackedNode[nodeCount]          (scene graph, parents first, each with a range of meshes)
+		PackedTexture[textureCount]    (material table, referenced by range from each mesh)
+		PackedDependency[dependencyCount] (other files the source was imported from, like OBJ material libraries)
+		string blob                    (texture types and paths, source and dependency paths)
+		vertex blob                    (Vertex[vertexCount], every mesh back to back, 64 byte aligned)
+		index blob                     (uint16_t or uint32_t[indexCount], relative to each mesh's first vertex, 64 byte aligned;
+		                                each mesh's full resolution indices are followed by its simplified LODs)
+
+	Indices are 16-bit if no mesh has more than MAX_SHORT_INDEX_VERTICES vertices, 32-bit otherwise.
+
+	The header also records which source file and import flags the data came from, and the
+	dependency table the other files the import read, which is what the mesh cache uses to decide
+	whether a packed file is still up to date.
+*/
+
+const uint32_t PACKED_MODEL_VERSION = 6;
+const uint32_t PACKED_MODEL_ALIGNMENT = 64;
+const std::string PACKED_MODEL_EXTENSION = ".pmodel";
+
+struct PackedHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t vertexSize;
+	uint32_t meshCount;
+	uint32_t textureCount;
+
+	// Source this file was converted from
+	uint32_t importFlags;
+	uint32_t sourcePathLength;
+	uint64_t sourcePathOffset;
+	uint64_t sourceSize;
+	int64_t sourceMtime;
+	uint64_t contentHash;
+
+	// Sections
+	uint64_t meshTableOffset;
+	uint64_t textureTableOffset;
+	uint64_t stringOffset;
+	uint64_t stringSize;
+	uint64_t vertexOffset;
+	uint64_t vertexCount;
+	uint64_t indexOffset;
+	uint64_t indexCount;
+	uint64_t nodeTableOffset;
+	uint32_t nodeCount;
+	uint32_t indexSize;	// Bytes per index, 2 or 4
+	uint64_t dependencyTableOffset;
+	uint32_t dependencyCount;
+	uint32_t padding;
+};
+
+struct PackedMesh {
+	uint32_t firstVertex;
+	uint32_t vertexCount;
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	uint32_t firstTexture;
+	uint32_t textureCount;
+
+	// Object space bounds, precomputed at import
+	float boundsMin[3];
+	float boundsMax[3];
+	float sphereCenter[3];
+	float sphereRadius;
+
+	// Simplified levels of detail, LOD 1 onwards, as ranges of the index blob
+	uint32_t lodCount;	// Including the full resolution range above
+	uint32_t lodFirstIndex[MAX_MESH_LODS - 1];
+	uint32_t lodIndexCount[MAX_MESH_LODS - 1];
+	float lodError[MAX_MESH_LODS - 1];
+};
+
+struct PackedNode {
+	int32_t parent;
+	uint32_t firstMesh;
+	uint32_t meshCount;
+	uint32_t nameOffset;
+	uint32_t nameLength;
+	uint32_t padding;
+	float localTransform[16];	// Column major
+};
+
+struct PackedTexture {
+	uint32_t typeOffset;
+	uint32_t typeLength;
+	uint32_t pathOffset;
+	uint32_t pathLength;
+};
+
+struct PackedDependency {
+	uint32_t pathOffset;
+	uint32_t pathLength;
+	uint64_t size;
+	int64_t mtime;
+	uint64_t contentHash;
+};
+
+// A file as it was when a packed model was converted from it
+struct PackedSourceFile {
+	std::string path;
+	uint64_t size = 0;
+	int64_t mtime = 0;
+	uint64_t contentHash = 0;
+};
+
+// Identifies the source file a packed model was converted from, and the files it references
+struct PackedSource : PackedSourceFile {
+	unsigned int importFlags = 0;
+	std::vector<PackedSourceFile> dependencies;
+};
+
+// Read-only view of a memory mapped packed model
+class PackedModel
+{
+public:
+	// Methods
+	bool open(const std::string& path);
+	void close();
+	bool isOpen() const { return file.isOpen(); }
+
+	const PackedHeader& header() const;
+	const PackedMesh* meshes() const;
+	const Vertex* vertices() const;
+	const void* indices() const;	// Of header().indexSize bytes each
+	std::vector<TextureRef> textures(const PackedMesh& mesh) const;
+	std::vector<ModelNode> nodes() const;
+	std::string sourcePath() const;
+	std::vector<PackedSourceFile> dependencies() const;
+
+private:
+	MappedFile file;
+	bool validate() const;
+	std::string string(uint64_t offset, uint32_t length) const;
+};
+
+// True if path names a packed model file
+bool isPackedModelPath(const std::string& path);
+
+// Write meshes and their scene graph as a packed model. Returns false if the file could not be written.
+bool writePackedModel(const std::string& path, const std::vector<MeshData>& meshes, const std::vector<ModelNode>& nodes, const PackedSource& source);
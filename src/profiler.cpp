@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <glad/glad.h>
+#include "profiler.h"
+
+// Queries are generated in batches as frames need more of them
+const unsigned int PROFILER_QUERY_BATCH = 64;
+
+Profiler& Profiler::shared()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+// Both clocks start at zero on the first enable, so CPU and GPU scopes line up in the trace
+void Profiler::setEnabled(bool enable)
+{
+	if (enable && !enabled && epoch == std::chrono::steady_clock::time_point())
+	{
+		epoch = std::chrono::steady_clock::now();
+		GLint64 timestamp = 0;
+		glGetInteger64v(GL_TIMESTAMP, &timestamp);
+		gpuEpoch = timestamp;
+	}
+	enabled = enable;
+}
+
+// Move on to the next slot of the ring, reading back the frame that used it last. Must not be
+// called while a scope is open.
+void Profiler::beginFrame()
+{
+	if (!enabled)
+		return;
+	if (!openScopes.empty())
+	{
+		std::cout << "ERROR::PROFILER::beginFrame called inside scope '" << slots[frame % PROFILER_FRAME_LATENCY].scopes[openScopes.back()].name
+			<< "'" << std::endl;
+		return;
+	}
+
+	frame++;
+	FrameSlot& slot = slots[frame % PROFILER_FRAME_LATENCY];
+	resolve(slot);
+	slot.frame = frame;
+}
+
+// Names must outlive the profiler, string literals are expected
+unsigned int Profiler::beginScope(const char* name)
+{
+	FrameSlot& slot = slots[frame % PROFILER_FRAME_LATENCY];
+	ScopeRecord record;
+	record.name = name;
+	record.depth = static_cast<unsigned int>(openScopes.size());
+	record.queryBegin = nextQuery(slot);
+	record.queryEnd = record.queryBegin;
+	glQueryCounter(record.queryBegin, GL_TIMESTAMP);
+	record.cpuBegin = cpuNow();
+	record.cpuEnd = record.cpuBegin;
+
+	unsigned int scope = static_cast<unsigned int>(slot.scopes.size());
+	slot.scopes.push_back(record);
+	openScopes.push_back(scope);
+	return scope;
+}
+
+void Profiler::endScope(unsigned int scope)
+{
+	FrameSlot& slot = slots[frame % PROFILER_FRAME_LATENCY];
+	if (openScopes.empty() || openScopes.back() != scope)
+		return;
+
+	ScopeRecord& record = slot.scopes[scope];
+	record.cpuEnd = cpuNow();
+	record.queryEnd = nextQuery(slot);
+	glQueryCounter(record.queryEnd, GL_TIMESTAMP);
+	openScopes.pop_back();
+}
+
+// Read back every frame still in flight, oldest first, waiting for the GPU if needed
+void Profiler::flush()
+{
+	if (!openScopes.empty())
+		return;
+	for (unsigned int i = 1; i <= PROFILER_FRAME_LATENCY; i++)
+		resolve(slots[(frame + i) % PROFILER_FRAME_LATENCY]);
+}
+
+// Flush and delete the queries. Must be called while the context is still current.
+void Profiler::release()
+{
+	flush();
+	for (FrameSlot& slot : slots)
+	{
+		if (!slot.queries.empty())
+			glDeleteQueries(static_cast<GLsizei>(slot.queries.size()), slot.queries.data());
+		slot.queries.clear();
+		slot.queriesUsed = 0;
+	}
+	enabled = false;
+}
+
+int64_t Profiler::cpuNow() const
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+unsigned int Profiler::nextQuery(FrameSlot& slot)
+{
+	if (slot.queriesUsed == slot.queries.size())
+	{
+		slot.queries.resize(slot.queries.size() + PROFILER_QUERY_BATCH);
+		glGenQueries(PROFILER_QUERY_BATCH, &slot.queries[slot.queries.size() - PROFILER_QUERY_BATCH]);
+	}
+	return slot.queries[slot.queriesUsed++];
+}
+
+// Add the slot's scopes to the statistics and the trace, and free it for reuse
+void Profiler::resolve(FrameSlot& slot)
+{
+	for (const ScopeRecord& record : slot.scopes)
+	{
+		GLuint64 gpuBegin = 0, gpuEnd = 0;
+		glGetQueryObjectui64v(record.queryBegin, GL_QUERY_RESULT, &gpuBegin);
+		glGetQueryObjectui64v(record.queryEnd, GL_QUERY_RESULT, &gpuEnd);
+		double cpuMs = (record.cpuEnd - record.cpuBegin) / 1e6;
+		double gpuMs = gpuEnd > gpuBegin ? (gpuEnd - gpuBegin) / 1e6 : 0.0;
+
+		auto found = statsIndex.find(record.name);
+		if (found == statsIndex.end())
+		{
+			found = statsIndex.emplace(record.name, stats.size()).first;
+			ScopeStats scopeStats;
+			scopeStats.name = record.name;
+			scopeStats.depth = record.depth;
+			scopeStats.cpuMin = cpuMs;
+			scopeStats.gpuMin = gpuMs;
+			stats.push_back(scopeStats);
+		}
+		ScopeStats& scopeStats = stats[found->second];
+		scopeStats.count++;
+		scopeStats.cpuTotal += cpuMs;
+		scopeStats.cpuMin = std::min(scopeStats.cpuMin, cpuMs);
+		scopeStats.cpuMax = std::max(scopeStats.cpuMax, cpuMs);
+		scopeStats.gpuTotal += gpuMs;
+		scopeStats.gpuMin = std::min(scopeStats.gpuMin, gpuMs);
+		scopeStats.gpuMax = std::max(scopeStats.gpuMax, gpuMs);
+
+		if (events.size() < PROFILER_MAX_TRACE_EVENTS)
+		{
+			double gpuStart = (static_cast<int64_t>(gpuBegin) - gpuEpoch) / 1e3;
+			events.push_back(TraceEvent{ record.name, slot.frame, record.cpuBegin / 1e3, cpuMs * 1e3, gpuStart, gpuMs * 1e3 });
+		}
+	}
+	slot.scopes.clear();
+	slot.queriesUsed = 0;
+}
+
+// One line per scope, nested scopes indented under the first scope they were seen in
+void Profiler::printStats() const
+{
+	std::printf("%-32s %8s %10s %10s %10s %10s\n", "Scope", "Count", "CPU mean", "CPU max", "GPU mean", "GPU max");
+	for (const ScopeStats& scope : stats)
+	{
+		std::string name = std::string(scope.depth * 2, ' ') + scope.name;
+		std::printf("%-32s %8u %8.3fms %8.3fms %8.3fms %8.3fms\n", name.c_str(), scope.count, scope.cpuMean(), scope.cpuMax,
+			scope.gpuMean(), scope.gpuMax);
+	}
+}
+
+static std::string escapeJson(const char* text)
+{
+	std::string escaped;
+	for (; *text; text++)
+	{
+		if (*text == '"' || *text == '\\')
+			escaped += '\\';
+		escaped += *text;
+	}
+	return escaped;
+}
+
+// Chrome trace event format: complete ("X") events in microseconds, CPU on thread 1 and GPU on thread 2
+bool Profiler::writeChromeTrace(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file)
+	{
+		std::cout << "ERROR::PROFILER::Could not write " << path << std::endl;
+		return false;
+	}
+
+	file << "{\"traceEvents\":[\n"
+		<< "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n"
+		<< "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+	file.precision(3);
+	file << std::fixed;
+	for (const TraceEvent& event : events)
+	{
+		std::string name = escapeJson(event.name);
+		file << ",\n{\"name\":\"" << name << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << event.cpuBegin
+			<< ",\"dur\":" << event.cpuDuration << ",\"args\":{\"frame\":" << event.frame << "}}"
+			<< ",\n{\"name\":\"" << name << "\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":" << event.gpuBegin
+			<< ",\"dur\":" << event.gpuDuration << ",\"args\":{\"frame\":" << event.frame << "}}";
+	}
+	file << "\n]}\n";
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+const unsigned int PROFILER_FRAME_LATENCY = 4;		// Frames in flight before their GPU timestamps are read
+const size_t PROFILER_MAX_TRACE_EVENTS = 1 << 20;	// Trace events kept for export, later scopes only count in the statistics
+
+// Totals of every recorded instance of a scope, in milliseconds
+struct ScopeStats {
+	std::string name;
+	unsigned int depth = 0;			// Nesting depth the scope was first seen at
+	unsigned int count = 0;
+	double cpuTotal = 0.0, cpuMin = 0.0, cpuMax = 0.0;
+	double gpuTotal = 0.0, gpuMin = 0.0, gpuMax = 0.0;
+
+	double cpuMean() const { return count ? cpuTotal / count : 0.0; }
+	double gpuMean() const { return count ? gpuTotal / count : 0.0; }
+};
+
+/*
+	Frame profiler for named, nested scopes on the GL thread. Each scope records its CPU wall time
+	and a GL_TIMESTAMP query at either end, which gives the GPU time between the commands issued
+	before and after it. Timestamps are used rather than GL_TIME_ELAPSED because elapsed queries
+	cannot nest.
+
+	Queries come from a ring of PROFILER_FRAME_LATENCY frames. A frame's results are read when its
+	slot comes around again, when the GPU has long finished with it, so profiling never stalls the
+	pipeline. Resolved scopes are added to per-name statistics and kept as Chrome trace events
+	(chrome://tracing or ui.perfetto.dev), with CPU and GPU on separate tracks.
+
+	The profiler is off by default, and disabled scopes cost one branch. Scopes are meant to be
+	opened with PROFILE_SCOPE, which closes them at the end of the enclosing block.
+*/
+class Profiler
+{
+public:
+	// Constructor
+	Profiler() = default;
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+
+	// Methods
+	void setEnabled(bool enabled);
+	bool isEnabled() const { return enabled; }
+	void beginFrame();
+	unsigned int beginScope(const char* name);
+	void endScope(unsigned int scope);
+	void flush();
+	void release();
+
+	const std::vector<ScopeStats>& getStats() const { return stats; }
+	void printStats() const;
+	bool writeChromeTrace(const std::string& path) const;
+
+	// Profiler of the GL thread
+	static Profiler& shared();
+
+private:
+	struct ScopeRecord {
+		const char* name;
+		unsigned int depth;
+		int64_t cpuBegin, cpuEnd;		// Nanoseconds since the profiler was enabled
+		unsigned int queryBegin, queryEnd;
+	};
+
+	struct FrameSlot {
+		uint64_t frame = 0;
+		std::vector<ScopeRecord> scopes;
+		std::vector<unsigned int> queries;
+		unsigned int queriesUsed = 0;
+	};
+
+	struct TraceEvent {
+		const char* name;
+		uint64_t frame;
+		double cpuBegin, cpuDuration;	// Microseconds
+		double gpuBegin, gpuDuration;
+	};
+
+	bool enabled = false;
+	uint64_t frame = 0;
+	FrameSlot slots[PROFILER_FRAME_LATENCY];
+	std::vector<unsigned int> openScopes;
+	std::chrono::steady_clock::time_point epoch;
+	int64_t gpuEpoch = 0;			// GPU timestamp at epoch, to put both clocks on one timeline
+
+	std::vector<ScopeStats> stats;
+	std::unordered_map<std::string, size_t> statsIndex;
+	std::vector<TraceEvent> events;
+
+	int64_t cpuNow() const;
+	unsigned int nextQuery(FrameSlot& slot);
+	void resolve(FrameSlot& slot);
+};
+
+// Profiles the rest of the enclosing block
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* name)
+	{
+		Profiler& profiler = Profiler::shared();
+		if (profiler.isEnabled())
+			scope = static_cast<int>(profiler.beginScope(name));
+	}
+	~ProfileScope()
+	{
+		if (scope >= 0)
+			Profiler::shared().endScope(static_cast<unsigned int>(scope));
+	}
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	int scope = -1;
+};
+
+#define PROFILE_SCOPE_CONCAT_(a, b) a##b
+#define PROFILE_SCOPE_CONCAT(a, b) PROFILE_SCOPE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_SCOPE_CONCAT(profileScope, __LINE__)(name)
@@ -0,0 +1,120 @@
+#include <random>
+#include <glm/gtc/matrix_transform.hpp>
+#include "scene.h"
+#include "profiler.h"
+
+const std::string VERTEX_SHADER_PATH = std::string(PROJECT_ROOT_DIR) + "/assets/vert.glsl";
+const std::string FRAGMENT_SHADER_PATH = std::string(PROJECT_ROOT_DIR) + "/assets/frag.glsl";
+
+// The shader program is compiled for the light storage this context supports and the model's vertex format
+Scene::Scene(const std::string& modelPath, VertexFormat vertexFormat, unsigned int pointLightCount, unsigned int lightSeed)
+	: dirLight(glm::vec3(2.f, -2.f, -1.f), glm::vec3(.2f), glm::vec3(1.f), glm::vec3(1.f), 16),
+	lights(dirLight),
+	model(modelPath, vertexFormat),
+	shader(VERTEX_SHADER_PATH.c_str(), FRAGMENT_SHADER_PATH.c_str(), lights.getShaderDefines() + getVertexShaderDefines(model.getVertexFormat()),
+		lights.getShaderVersion()),
+	cameraBuffer(CAMERA_BLOCK_BINDING, sizeof(CameraBlock))
+{
+	addRandomPointLights(pointLightCount, lightSeed);
+
+	// Shared uniform blocks
+	bindUniformBlocks(shader);
+	lights.setupShader(shader);
+
+	// Per object uniforms, looked up once so the render loop does no string building
+	shader.use();
+	shader.setFloat("material.shininess", dirLight.shininess);
+	shader.setInt("lightGrid", LIGHT_GRID_TEXTURE_UNIT);
+	shader.setInt("lightIndices", LIGHT_INDEX_TEXTURE_UNIT);
+	modelLoc = shader.getUniformLocation("model");
+	normalModelLoc = shader.getUniformLocation("normalModel");
+}
+
+// Scatter point lights with random colors and ranges around the origin. The same seed always
+// gives the same lights.
+void Scene::addRandomPointLights(unsigned int count, unsigned int seed)
+{
+	std::mt19937 random(seed);
+	std::uniform_int_distribution<int> position(-10, 10);
+	std::uniform_int_distribution<int> color(0, 9);
+	std::uniform_int_distribution<int> specular(1, 10);
+	std::uniform_int_distribution<int> range(7, 32);
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		// Construct point light
+		PointLight pointLight(glm::vec3(position(random), position(random), position(random)), 0.05f, 1.f, 1.f, 16);
+
+		// Assign ambient
+		pointLight.ambient = glm::vec3(0.05f);
+
+		// Diffuse
+		pointLight.diffuse = glm::vec3(color(random) + .05f, color(random) + .05f, color(random) + .05f);
+
+		// Specular
+		pointLight.specular = glm::vec3(specular(random) * 0.1f);
+
+		// Attenuation, which also sets the light's radius
+		pointLight.setAttenuationRange(static_cast<float>(range(random)));
+		lights.addPointLight(pointLight);
+	}
+}
+
+// Draw one frame into the bound framebuffer, which is width x height pixels
+void Scene::render(const Camera& camera, int width, int height)
+{
+	PROFILE_SCOPE("render");
+	{
+		PROFILE_SCOPE("clear");
+		glClearColor(0.15f, 0.15f, 0.15f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	}
+
+	// Activate shader program
+	shader.use();
+
+	// Camera transformations
+	float aspect = static_cast<float>(width) / height;
+	glm::mat4 projectionMtrx = glm::perspective(glm::radians(camera.fov), aspect, NEAR_PLANE, FAR_PLANE);
+	CameraBlock cameraBlock = makeCameraBlock(camera, projectionMtrx);
+	{
+		PROFILE_SCOPE("uniforms");
+		cameraBuffer.update(&cameraBlock, sizeof(cameraBlock));
+
+		// Model transformations
+		shader.setMat4(modelLoc, modelMatrix);
+		glm::mat3 normalMtrx = glm::transpose(glm::inverse(glm::mat3(modelMatrix)));
+		shader.setMat3(normalModelLoc, normalMtrx);
+	}
+
+	// Send lights that changed, drop the ones that can't light anything on screen and bin the rest for this view
+	{
+		PROFILE_SCOPE("light upload");
+		lights.upload();
+		lights.bind();
+	}
+	Frustum frustum = camera.getFrustum(projectionMtrx);
+	{
+		PROFILE_SCOPE("culling");
+		model.cull(frustum, modelMatrix);
+		std::vector<AABB> visibleBounds;
+		model.appendVisibleBounds(visibleBounds, modelMatrix);
+		lights.cullPointLights(frustum, visibleBounds);
+	}
+	{
+		PROFILE_SCOPE("light clusters");
+		lightClusters.update(cameraBlock.view, glm::radians(camera.fov), aspect, NEAR_PLANE, FAR_PLANE, width, height,
+			lights.getPointLights(), lights.getVisibleLights());
+		lightClusters.bind();
+	}
+
+	// Draw model, with distant meshes at coarser levels of detail
+	{
+		PROFILE_SCOPE("lod selection");
+		model.selectLods(camera.position, glm::radians(camera.fov), static_cast<float>(height), modelMatrix);
+	}
+	{
+		PROFILE_SCOPE("model draw");
+		model.draw(shader);
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <glm/glm.hpp>
+#include "shader.cpp"
+#include "camera.h"
+#include "model.h"
+#include "lighting.h"
+#include "uniform_buffers.h"
+#include "light_clusters.h"
+#include "light_manager.h"
+
+const float NEAR_PLANE = .1f;
+const float FAR_PLANE = 100.f;
+
+/*
+	The scene every executable renders: one model lit by a directional light and a set of point
+	lights, drawn with the shaders in assets. It owns everything a frame needs, so the interactive
+	viewer and the benchmark draw exactly the same work.
+
+	Point lights are placed randomly from a seed, so a run can be repeated light for light.
+*/
+class Scene
+{
+public:
+	// Constructor
+	Scene(const std::string& modelPath, VertexFormat vertexFormat, unsigned int pointLightCount, unsigned int lightSeed);
+
+	// Methods
+	void addRandomPointLights(unsigned int count, unsigned int seed);
+	void render(const Camera& camera, int width, int height);
+	Model& getModel() { return model; }
+	LightManager& getLights() { return lights; }
+	const glm::mat4& getModelMatrix() const { return modelMatrix; }
+
+private:
+	DirLight dirLight;
+	LightManager lights;
+	Model model;
+	Shader shader;
+	UniformBuffer cameraBuffer;
+	LightClusters lightClusters;	// Point lights are binned into view space froxels every frame
+	glm::mat4 modelMatrix = glm::mat4(1.f);
+	int modelLoc, normalModelLoc;
+};
@@ -4,6 +4,8 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+#include <vector>
 #include "glad/glad.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -12,9 +14,10 @@ class Shader
 {
 public:
     unsigned int ID;
-    // constructor generates the shader on the fly
+    // constructor generates the shader on the fly. defines are inserted right after the #version line
+    // of both sources to compile a variant, and version replaces that line if given.
     // ------------------------------------------------------------------------
-    Shader(const char *vertexPath, const char *fragmentPath)
+    Shader(const char *vertexPath, const char *fragmentPath, const std::string &defines = "", const char *version = nullptr)
     {
         // 1. retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
@@ -44,6 +47,8 @@ public:
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
         }
+        vertexCode = addPreamble(vertexCode, defines, version);
+        fragmentCode = addPreamble(fragmentCode, defines, version);
         const char *vShaderCode = vertexCode.c_str();
         const char *fShaderCode = fragmentCode.c_str();
         // 2. compile shaders
@@ -67,6 +72,8 @@ public:
         // delete the shaders as they're linked into our program now and no longer necessary
         glDeleteShader(vertex);
         glDeleteShader(fragment);
+        // 3. look up every uniform location once, so setting uniforms never asks the driver again
+        cacheUniformLocations();
     }
     // activate the shader
     // ------------------------------------------------------------------------
@@ -74,39 +81,141 @@ public:
     {
         glUseProgram(ID);
     }
+    // location of a uniform, or -1 if the program has no such active uniform. Look locations up once
+    // and pass them to the setters below to avoid any string handling per frame.
+    // ------------------------------------------------------------------------
+    int getUniformLocation(const std::string &name) const
+    {
+        auto it = uniformLocations.find(name);
+        return it != uniformLocations.end() ? it->second : -1;
+    }
+    // point a uniform block of the program at a buffer binding point, if the program uses that block
+    // ------------------------------------------------------------------------
+    void bindUniformBlock(const std::string &blockName, unsigned int binding) const
+    {
+        unsigned int blockIndex = glGetUniformBlockIndex(ID, blockName.c_str());
+        if (blockIndex != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, blockIndex, binding);
+    }
+    // point a shader storage block of the program at a buffer binding point. Needs GL 4.3, and does
+    // nothing if glad was generated for an older version.
+    // ------------------------------------------------------------------------
+    void bindStorageBlock(const std::string &blockName, unsigned int binding) const
+    {
+#ifdef GL_VERSION_4_3
+        unsigned int blockIndex = glGetProgramResourceIndex(ID, GL_SHADER_STORAGE_BLOCK, blockName.c_str());
+        if (blockIndex != GL_INVALID_INDEX)
+            glShaderStorageBlockBinding(ID, blockIndex, binding);
+#endif
+    }
     // utility uniform functions
     // ------------------------------------------------------------------------
     void setBool(const std::string &name, bool value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        setBool(getUniformLocation(name), value);
+    }
+    void setBool(int location, bool value) const
+    {
+        glUniform1i(location, (int)value);
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string &name, int value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        setInt(getUniformLocation(name), value);
+    }
+    void setInt(int location, int value) const
+    {
+        glUniform1i(location, value);
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string &name, float value) const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        setFloat(getUniformLocation(name), value);
+    }
+    void setFloat(int location, float value) const
+    {
+        glUniform1f(location, value);
     }
     // ------------------------------------------------------------------------
     void setVec3(const std::string &name, glm::vec3 value) const
     {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), value.x, value.y, value.z);
+        setVec3(getUniformLocation(name), value);
+    }
+    void setVec3(int location, glm::vec3 value) const
+    {
+        glUniform3f(location, value.x, value.y, value.z);
     }
     // ------------------------------------------------------------------------
     void setMat4(const std::string &name, glm::mat4 value) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+        setMat4(getUniformLocation(name), value);
+    }
+    void setMat4(int location, const glm::mat4 &value) const
+    {
+        glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
     }
     // ------------------------------------------------------------------------
     void setMat3(const std::string &name, glm::mat3 value)
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+        setMat3(getUniformLocation(name), value);
+    }
+    void setMat3(int location, const glm::mat3 &value)
+    {
+        glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(value));
     }
 
 private:
+    std::unordered_map<std::string, int> uniformLocations;
+
+    // insert defines after the #version line of a shader source, replacing that line with version if given
+    // ------------------------------------------------------------------------
+    static std::string addPreamble(const std::string &source, const std::string &defines, const char *version)
+    {
+        size_t bodyStart = 0;
+        if (source.compare(0, 8, "#version") == 0)
+        {
+            size_t lineEnd = source.find('\n');
+            bodyStart = lineEnd == std::string::npos ? source.size() : lineEnd + 1;
+        }
+        std::string versionLine = version ? std::string(version) + "\n" : source.substr(0, bodyStart);
+        return versionLine + defines + source.substr(bodyStart);
+    }
+    // fill uniformLocations with every active uniform of the linked program
+    // ------------------------------------------------------------------------
+    void cacheUniformLocations()
+    {
+        int count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+        std::vector<char> buffer(maxLength + 1);
+        for (int i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type;
+            glGetActiveUniform(ID, i, static_cast<GLsizei>(buffer.size()), &length, &size, &type, buffer.data());
+            std::string name(buffer.data(), length);
+
+            // members of uniform blocks have no location
+            int location = glGetUniformLocation(ID, name.c_str());
+            if (location < 0)
+                continue;
+            uniformLocations[name] = location;
+
+            // arrays of basic types are reported once as "name[0]", register every element and the bare name too
+            if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+            {
+                std::string base = name.substr(0, name.size() - 3);
+                uniformLocations[base] = location;
+                for (int element = 1; element < size; element++)
+                {
+                    std::string elementName = base + "[" + std::to_string(element) + "]";
+                    uniformLocations[elementName] = glGetUniformLocation(ID, elementName.c_str());
+                }
+            }
+        }
+    }
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(unsigned int shader, std::string type)
@@ -0,0 +1,155 @@
+#include <filesystem>
+#include <iostream>
+#include <glad/glad.h>
+#include "stb_image.h"
+#include "texture_loader.h"
+#include "thread_pool.h"
+
+// Neutral grey shown until the real image has been decoded and uploaded
+const unsigned char PLACEHOLDER_PIXEL[4] = { 128, 128, 128, 255 };
+
+TextureLoader::TextureLoader()
+{
+	// Construct the pool first, so it is destroyed after us and still runs the decodes the destructor waits for
+	ThreadPool::shared();
+}
+
+// Queued decodes report back into this object, so wait until every one of them has finished
+// before freeing what they decoded
+TextureLoader::~TextureLoader()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	imageDecoded.wait(lock, [this]() { return decoded.size() == pending; });
+	for (DecodedImage& image : decoded)
+		stbi_image_free(image.data);
+}
+
+TextureLoader& TextureLoader::shared()
+{
+	static TextureLoader loader;
+	return loader;
+}
+
+// Return the texture registered for filename, or create it with a placeholder image and queue
+// its decode. Call on the GL thread.
+unsigned int TextureLoader::load(const std::string& filename)
+{
+	std::string key = normalizePath(filename);
+	auto it = textures.find(key);
+	if (it != textures.end())
+		return it->second.id;
+
+	unsigned int textureID;
+	glGenTextures(1, &textureID);
+	textures[key].id = textureID;
+
+	glBindTexture(GL_TEXTURE_2D, textureID);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_PIXEL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pending++;
+	}
+
+	ThreadPool::shared().submit([this, textureID, key, filename]() {
+		DecodedImage image{ textureID, key, filename, nullptr, 0, 0, 0 };
+		image.data = stbi_load(filename.c_str(), &image.width, &image.height, &image.components, 0);
+
+		// Notify under the lock, the destructor may run as soon as it is released
+		std::lock_guard<std::mutex> lock(mutex);
+		decoded.push_back(image);
+		imageDecoded.notify_all();
+	});
+
+	return textureID;
+}
+
+// Upload every image decoded so far and return how many were handled. Call on the GL thread.
+unsigned int TextureLoader::processUploads()
+{
+	std::deque<DecodedImage> ready;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		ready.swap(decoded);
+		pending -= ready.size();
+	}
+
+	for (const DecodedImage& image : ready)
+		upload(image);
+	return static_cast<unsigned int>(ready.size());
+}
+
+// Block until every queued texture has been decoded and uploaded. Call on the GL thread.
+void TextureLoader::finishUploads()
+{
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			imageDecoded.wait(lock, [this]() { return pending == 0 || !decoded.empty(); });
+			if (pending == 0)
+				return;
+		}
+		processUploads();
+	}
+}
+
+// Registered texture for filename, or nullptr if it was never loaded. Call on the GL thread.
+const TextureLoader::TextureInfo* TextureLoader::find(const std::string& filename) const
+{
+	auto it = textures.find(normalizePath(filename));
+	return it != textures.end() ? &it->second : nullptr;
+}
+
+bool TextureLoader::hasPending()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return pending > 0;
+}
+
+void TextureLoader::upload(const DecodedImage& image)
+{
+	if (image.data)
+	{
+		GLenum format = GL_RGBA;
+		if (image.components == 1)
+			format = GL_RED;
+		else if (image.components == 2)
+			format = GL_RG;
+		else if (image.components == 3)
+			format = GL_RGB;
+		else if (image.components == 4)
+			format = GL_RGBA;
+
+		glBindTexture(GL_TEXTURE_2D, image.textureID);
+		glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.data);
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+		TextureInfo& info = textures[image.key];
+		info.width = image.width;
+		info.height = image.height;
+		info.components = image.components;
+		info.loaded = true;
+
+		stbi_image_free(image.data);
+	}
+	else
+	{
+		// Keep the placeholder
+		std::cout << "ERROR::STBI_IMAGE::Texture failed to load at path: " << image.filename << std::endl;
+	}
+}
+
+// Registry key of a texture file, so different spellings of the same path share one texture
+std::string TextureLoader::normalizePath(const std::string& filename)
+{
+	std::error_code error;
+	std::filesystem::path path = std::filesystem::absolute(filename, error);
+	if (error)
+		path = filename;
+	return path.lexically_normal().generic_string();
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/*
+	Decodes textures on the shared thread pool while the GL thread only does the uploads.
+
+	load() creates the GL texture right away with a small placeholder image, so the returned id can
+	be used (and drawn with) immediately, and queues the decode. processUploads() must be called on
+	the GL thread, typically once per frame, to replace placeholders with the decoded images as
+	they arrive. Loading a model with many large textures therefore costs roughly the slowest
+	decode instead of the sum of all of them.
+
+	Every texture is registered under its normalized absolute path, so any model referencing a file
+	that was already loaded (by itself or by another model) gets the existing GL texture back
+	instead of decoding it again. The registry is only touched from the GL thread.
+*/
+class TextureLoader
+{
+public:
+	// Constructor
+	TextureLoader();
+	TextureLoader(const TextureLoader&) = delete;
+	TextureLoader& operator=(const TextureLoader&) = delete;
+	~TextureLoader();
+
+	// Registered texture
+	struct TextureInfo {
+		unsigned int id;
+		int width = 0;
+		int height = 0;
+		int components = 0;
+		bool loaded = false;
+	};
+
+	// Methods
+	unsigned int load(const std::string& filename);
+	const TextureInfo* find(const std::string& filename) const;
+	unsigned int processUploads();
+	void finishUploads();
+	bool hasPending();
+
+	// Loader shared by all models
+	static TextureLoader& shared();
+
+private:
+	struct DecodedImage {
+		unsigned int textureID;
+		std::string key;
+		std::string filename;
+		unsigned char* data;
+		int width, height, components;
+	};
+
+	std::unordered_map<std::string, TextureInfo> textures;
+	std::deque<DecodedImage> decoded;
+	std::mutex mutex;
+	std::condition_variable imageDecoded;
+	size_t pending = 0;
+
+	void upload(const DecodedImage& image);
+	static std::string normalizePath(const std::string& filename);
+};
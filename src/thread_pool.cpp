@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	if (threadCount == 0)
+		threadCount = 1;
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	taskAvailable.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+ThreadPool& ThreadPool::shared()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+// Queue a task to run on one of the workers
+void ThreadPool::submit(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		tasks.push_back(std::move(task));
+	}
+	taskAvailable.notify_one();
+}
+
+// Run body(i) for every i in [0, count) across the workers and the calling thread, and return
+// once all of them are done. The caller takes part, so this never waits on a busy pool.
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& body)
+{
+	if (count == 0)
+		return;
+
+	struct Batch {
+		std::atomic<size_t> next{ 0 };
+		std::atomic<size_t> done{ 0 };
+		std::mutex mutex;
+		std::condition_variable finished;
+	};
+	auto batch = std::make_shared<Batch>();
+
+	auto run = [batch, count, &body]() {
+		size_t completed = 0;
+		for (size_t i = batch->next++; i < count; i = batch->next++)
+		{
+			body(i);
+			completed++;
+		}
+		if (completed > 0 && (batch->done += completed) == count)
+		{
+			std::lock_guard<std::mutex> lock(batch->mutex);
+			batch->finished.notify_all();
+		}
+	};
+
+	// Helpers only pick up indices the caller hasn't claimed yet, so body stays alive for all of them
+	size_t helpers = std::min<size_t>(size(), count - 1);
+	for (size_t i = 0; i < helpers; i++)
+		submit(run);
+	run();
+
+	std::unique_lock<std::mutex> lock(batch->mutex);
+	batch->finished.wait(lock, [&]() { return batch->done == count; });
+}
+
+void ThreadPool::workerLoop()
+{
+	while (true)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			taskAvailable.wait(lock, [this]() { return stopping || !tasks.empty(); });
+			if (stopping && tasks.empty())
+				return;
+
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+		task();
+	}
+}
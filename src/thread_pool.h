@@ -0,0 +1,37 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running queued tasks. Used for CPU side loading work (mesh
+// flattening, image decoding) so that only GL calls are left for the context thread.
+class ThreadPool
+{
+public:
+	// Constructor
+	explicit ThreadPool(unsigned int threadCount = 0);
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	~ThreadPool();
+
+	// Methods
+	void submit(std::function<void()> task);
+	void parallelFor(size_t count, const std::function<void(size_t)>& body);
+	unsigned int size() const { return static_cast<unsigned int>(workers.size()); }
+
+	// Pool shared by all loading code, sized to the number of hardware threads
+	static ThreadPool& shared();
+
+private:
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable taskAvailable;
+	bool stopping = false;
+
+	void workerLoop();
+};
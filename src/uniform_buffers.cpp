@@ -0,0 +1,51 @@
+#include <cstddef>
+#include "uniform_buffers.h"
+
+static_assert(sizeof(CameraBlock) == 144 && offsetof(CameraBlock, viewPos) == 128, "CameraBlock must match the std140 layout of uniform Camera");
+static_assert(sizeof(DirLightBlock) == 64, "DirLightBlock must match the std140 layout of DirLight");
+static_assert(sizeof(LightBlock) == 80 && offsetof(LightBlock, pointLightCount) == 64, "LightBlock must match the std140 layout of uniform Lights");
+static_assert(sizeof(ClusterBlock) == 48, "ClusterBlock must match the std140 layout of uniform Clusters");
+
+UniformBuffer::UniformBuffer(unsigned int binding, size_t size)
+{
+	glGenBuffers(1, &ID);
+	glBindBuffer(GL_UNIFORM_BUFFER, ID);
+	glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glBindBufferBase(GL_UNIFORM_BUFFER, binding, ID);
+}
+
+void UniformBuffer::update(const void* data, size_t size, size_t offset)
+{
+	glBindBuffer(GL_UNIFORM_BUFFER, ID);
+	glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void bindUniformBlocks(Shader& shader)
+{
+	shader.bindUniformBlock("Camera", CAMERA_BLOCK_BINDING);
+	shader.bindUniformBlock("Lights", LIGHT_BLOCK_BINDING);
+	shader.bindUniformBlock("Clusters", CLUSTER_BLOCK_BINDING);
+}
+
+CameraBlock makeCameraBlock(const Camera& camera, const glm::mat4& projection)
+{
+	CameraBlock block = {};
+	block.projection = projection;
+	block.view = camera.getViewMatrix();
+	block.viewPos = camera.position;
+	return block;
+}
+
+LightBlock makeLightBlock(const DirLight& dirLight, unsigned int pointLightCount)
+{
+	LightBlock block = {};
+	block.dirLight.direction = dirLight.direction;
+	block.dirLight.ambient = dirLight.ambient;
+	block.dirLight.diffuse = dirLight.diffuse;
+	block.dirLight.specular = dirLight.specular;
+	block.pointLightCount = pointLightCount;
+	return block;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <glm/glm.hpp>
+#include "shader.cpp"
+#include "camera.h"
+#include "lighting.h"
+
+/*
+	std140 uniform blocks shared by every shader program. Each block lives in its own uniform buffer
+	bound to a fixed binding point, so a block is uploaded with a single glBufferSubData no matter how
+	many programs read it, and a new program only needs bindUniformBlocks() once after it is created.
+
+	The *Block structs below mirror the block layouts declared in the shaders byte for byte. vec3
+	members are padded out to 16 bytes as std140 requires.
+*/
+
+// Binding points
+const unsigned int CAMERA_BLOCK_BINDING = 0;
+const unsigned int LIGHT_BLOCK_BINDING = 1;
+const unsigned int CLUSTER_BLOCK_BINDING = 2;
+
+// uniform Camera
+struct CameraBlock {
+	glm::mat4 projection;
+	glm::mat4 view;
+	glm::vec3 viewPos;
+	float padding;
+};
+
+// DirLight inside uniform Lights
+struct DirLightBlock {
+	glm::vec3 direction;
+	float padding0;
+	glm::vec3 ambient;
+	float padding1;
+	glm::vec3 diffuse;
+	float padding2;
+	glm::vec3 specular;
+	float padding3;
+};
+
+// uniform Lights. The point lights themselves live in LightManager's light buffer.
+struct LightBlock {
+	DirLightBlock dirLight;
+	unsigned int pointLightCount;
+	float padding[3];
+};
+
+// uniform Clusters
+struct ClusterBlock {
+	glm::uvec4 gridSize;	// Tiles in x, tiles in y, depth slices
+	glm::vec4 tileSize;	// Pixels per tile in x and y
+	glm::vec4 sliceParams;	// Depth slice of a view depth d is log(d) * x - y
+};
+
+class UniformBuffer
+{
+public:
+	unsigned int ID;
+
+	// Constructor
+	UniformBuffer(unsigned int binding, size_t size);
+
+	// Methods
+	void update(const void* data, size_t size, size_t offset = 0);
+};
+
+// Bind every shared block the program declares to its binding point
+void bindUniformBlocks(Shader& shader);
+
+// Fill blocks from the scene
+CameraBlock makeCameraBlock(const Camera& camera, const glm::mat4& projection);
+LightBlock makeLightBlock(const DirLight& dirLight, unsigned int pointLightCount);
@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "vertex_format.h"
+
+static_assert(sizeof(QuantizedVertex) == 16, "QuantizedVertex must stay tightly packed to be uploaded as raw bytes");
+
+size_t getVertexSize(VertexFormat format)
+{
+	return format == VertexFormat::Quantized ? sizeof(QuantizedVertex) : sizeof(Vertex);
+}
+
+std::string getVertexShaderDefines(VertexFormat format)
+{
+	return format == VertexFormat::Quantized ? "#define QUANTIZED_VERTICES 1\n" : "";
+}
+
+// Spread the 16-bit range over the bounds. Flat axes keep a scale of 0, every vertex lies on the offset.
+PositionDequantization makePositionDequantization(const AABB& bounds)
+{
+	PositionDequantization dequantization;
+	if (bounds.isEmpty())
+		return dequantization;
+
+	dequantization.offset = bounds.min;
+	dequantization.scale = bounds.max - bounds.min;
+	return dequantization;
+}
+
+void quantizeVertices(const Vertex* vertices, size_t count, const PositionDequantization& dequantization, QuantizedVertex* result)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		const Vertex& vertex = vertices[i];
+		QuantizedVertex& quantized = result[i];
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float scale = dequantization.scale[axis];
+			float unit = scale > 0.f ? (vertex.position[axis] - dequantization.offset[axis]) / scale : 0.f;
+			quantized.position[axis] = static_cast<uint16_t>(std::lround(std::clamp(unit, 0.f, 1.f) * 65535.f));
+		}
+		quantized.position[3] = 0;
+		quantized.normal = packNormal(vertex.normal);
+		quantized.texCoords[0] = floatToHalf(vertex.texCoords.x);
+		quantized.texCoords[1] = floatToHalf(vertex.texCoords.y);
+	}
+}
+
+// IEEE 754 binary16, rounded to nearest even. Values beyond the half range become infinity.
+uint16_t floatToHalf(float value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+	int exponent = static_cast<int>((bits >> 23) & 0xFF) - 127 + 15;
+	uint32_t mantissa = bits & 0x7FFFFF;
+
+	// NaN and infinity
+	if (((bits >> 23) & 0xFF) == 0xFF)
+		return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+
+	// Too large, infinity
+	if (exponent >= 31)
+		return sign | 0x7C00;
+
+	// Normal half
+	if (exponent > 0)
+	{
+		uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+		uint32_t rest = mantissa & 0x1FFF;
+		if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+			half++;	// May carry into the exponent, up to infinity, which is the right rounding
+		return sign | static_cast<uint16_t>(half);
+	}
+
+	// Subnormal half, or zero
+	if (exponent < -10)
+		return sign;
+	mantissa |= 0x800000;
+	int shift = 14 - exponent;
+	uint32_t half = mantissa >> shift;
+	uint32_t rest = mantissa & ((1u << shift) - 1);
+	uint32_t halfway = 1u << (shift - 1);
+	if (rest > halfway || (rest == halfway && (half & 1)))
+		half++;
+	return sign | static_cast<uint16_t>(half);
+}
+
+// Signed normalized 10-bit x, y, z in GL_INT_2_10_10_10_REV order, w left at 0
+uint32_t packNormal(const glm::vec3& normal)
+{
+	uint32_t packed = 0;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		int value = static_cast<int>(std::lround(std::clamp(normal[axis], -1.f, 1.f) * 511.f));
+		packed |= (static_cast<uint32_t>(value) & 0x3FF) << (axis * 10);
+	}
+	return packed;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mesh_data.h"
+
+/*
+	Layouts a Model can keep its vertices in on the GPU. Meshes are always imported and cached as
+	full float Vertex records, the quantized layout is only built while uploading them:
+
+		Float        Vertex, 32 bytes
+		Quantized    QuantizedVertex, 16 bytes:
+		             position  3 x 16-bit unorm, relative to the model's bounds (+ 16 bits padding)
+		             normal    GL_INT_2_10_10_10_REV, signed normalized
+		             texCoords 2 x half float
+
+	Positions are quantized against the bounds of the whole model, not of each mesh, so every mesh
+	can be dequantized with the same two uniforms and meshes still draw together in one multi-draw.
+	The vertex shader has to be compiled with the defines of the model's format.
+*/
+enum class VertexFormat {
+	Float,
+	Quantized
+};
+
+struct QuantizedVertex {
+	uint16_t position[4];
+	uint32_t normal;
+	uint16_t texCoords[2];
+};
+
+// Maps quantized positions back to model space: position = offset + quantized * scale
+struct PositionDequantization {
+	glm::vec3 offset = glm::vec3(0.f);
+	glm::vec3 scale = glm::vec3(1.f);
+};
+
+size_t getVertexSize(VertexFormat format);
+std::string getVertexShaderDefines(VertexFormat format);
+
+PositionDequantization makePositionDequantization(const AABB& bounds);
+void quantizeVertices(const Vertex* vertices, size_t count, const PositionDequantization& dequantization, QuantizedVertex* result);
+
+uint16_t floatToHalf(float value);
+uint32_t packNormal(const glm::vec3& normal);